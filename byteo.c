@@ -9,8 +9,8 @@
  * Ĺܣ
  *     @liת(asc2bcd | bcd2asc | bcd2int | int2bcd | asc2int | int2asc)
  *     @liַոضϺ(trim | rtrim | ltrim | atrim)
- *     @liַУ麯(isbreak | isdigits)
- *     @liֽλ㺯(ands | ors | xors | nots | reverse_bit | reverse_bits)
+ *     @liַУ麯(isbreak | isdigits | isxdigits | spandigits | spanxdigits)
+ *     @liֽλ㺯(ands | ors | xors | xorsn | nots | reverse_bit | reverse_bits)
  *     @liʮ(hexdump)
  */
 #include <ctype.h>
@@ -18,100 +18,267 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <limits.h>
+#include <stdint.h>
 #include "byteo.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTEO_X86 1
+#endif
+
+/** @brief ָ */
+#define BYTEO_SCALAR 0
+#define BYTEO_SSE2   1
+#define BYTEO_AVX2   2
+
+static int byteo_level = -1;
+
 /**
- * @brief תASCַΪBCD档
+ * @brief ȡõǰCPUֵָ֧״εʱ⡣
  * 
- * @param asc_buf ASCַ
- * @param asc_len ASCַȡ
- * @param bcd_buf BCDָ롣
- * @param bcd_len BCD泤ȡ
- * @param flags ת(0 | ABC_NUM | ABC_FORE | ABC_FILL | ABC_FCH)еһֵֵ
- *        ... fch ֵתABC_FCHøֵֵASCַ(0-9 a-f A-F)Χڡ
+ * @return BYTEO_SCALARBYTEO_SSE2BYTEO_AVX2
+ */
+static int byteo_cpu(void)
+{
+	int level = __atomic_load_n(&byteo_level, __ATOMIC_RELAXED);
+
+	if (level < 0) {
+		level = BYTEO_SCALAR;
+#ifdef BYTEO_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			level = BYTEO_AVX2;
+		} else if (__builtin_cpu_supports("sse2")) {
+			level = BYTEO_SSE2;
+		}
+#endif
+		__atomic_store_n(&byteo_level, level, __ATOMIC_RELAXED);
+	}
+	return level;
+}
+
+/**
+ * @brief תASCַΪֽڡ
+ * 
+ * @param c ASCַ
+ * @param num 0ʱַΧΪ(0-9 : ; < = > ?)Ϊ(0-9 a-f A-F)
+ * 
+ * @return ֵַֽǷ0xFF
+ */
+static inline U8 asc2nibble(const U8 c, const U8 num)
+{
+	if (num) {
+		return (c >= '0' && c <= '?') ? c - '0' : 0xFF;
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	} else if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	return 0xFF;
+}
+
+#ifdef BYTEO_X86
+/**
+ * @brief ת16ASCַΪֽڡ
+ * 
+ * @param c 16ASCַ
+ * @param num 0ʱABC_NUMΧУ顣
+ * @param bad Ƿַ루0ʾзǷַ
+ * 
+ * @return ÿֽһֵֽ
+ */
+__attribute__((target("sse2")))
+static inline __m128i asc2nibble_sse2(__m128i c, const U8 num, int *bad)
+{
+	__m128i d, l, digit, alpha;
+
+	if (num) {
+		d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+		//(c & 0xF0) == 0x30
+		digit = _mm_cmpeq_epi8(_mm_and_si128(c, _mm_set1_epi8((char)0xF0)), _mm_set1_epi8(0x30));
+		*bad = _mm_movemask_epi8(digit) ^ 0xFFFF;
+		return d;
+	}
+	d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+	digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+	l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+	alpha = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1)));
+	*bad = _mm_movemask_epi8(_mm_or_si128(digit, alpha)) ^ 0xFFFF;
+	l = _mm_sub_epi8(l, _mm_set1_epi8('a' - 10));
+	return _mm_or_si128(_mm_and_si128(digit, d), _mm_andnot_si128(digit, l));
+}
+
+/**
+ * @brief SSE2ÿת32ASCַΪ16ֽBCDǷַĿ鼴ֹͣ
+ * 
+ * @param asc ASCַ
+ * @param npairs תַ
+ * @param bcd BCD档
+ * @param num 0ʱABC_NUMΧУ顣
+ * 
+ * @return תַ
+ */
+__attribute__((target("sse2")))
+static size_t asc2bcd_sse2(const U8 *asc, size_t npairs, U8 *bcd, const U8 num)
+{
+	size_t k;
+	int bad1, bad2;
+	__m128i n1, n2, mask = _mm_set1_epi16(0x00FF);
+
+	for (k = 0; k + 16 <= npairs; k += 16, asc += 32, bcd += 16) {
+		n1 = asc2nibble_sse2(_mm_loadu_si128((const __m128i *)asc), num, &bad1);
+		n2 = asc2nibble_sse2(_mm_loadu_si128((const __m128i *)(asc + 16)), num, &bad2);
+		if (bad1 | bad2)
+			break;
+		//ÿ16λֽΪֽ߰ڣֽΪͰֽ
+		n1 = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(n1, 4), _mm_srli_epi16(n1, 8)), mask);
+		n2 = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(n2, 4), _mm_srli_epi16(n2, 8)), mask);
+		_mm_storeu_si128((__m128i *)bcd, _mm_packus_epi16(n1, n2));
+	}
+	return k;
+}
+
+/**
+ * @brief AVX2ÿת32ASCַΪ16ֽBCDǷַĿ鼴ֹͣ
+ * 
+ * @param asc ASCַ
+ * @param npairs תַ
+ * @param bcd BCD档
+ * @param num 0ʱABC_NUMΧУ顣
+ * 
+ * @return תַ
+ */
+__attribute__((target("avx2")))
+static size_t asc2bcd_avx2(const U8 *asc, size_t npairs, U8 *bcd, const U8 num)
+{
+	size_t k;
+	__m256i c, d, l, digit, alpha, valid;
+
+	for (k = 0; k + 16 <= npairs; k += 16, asc += 32, bcd += 16) {
+		c = _mm256_loadu_si256((const __m256i *)asc);
+		d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+		if (num) {
+			valid = _mm256_cmpeq_epi8(_mm256_and_si256(c, _mm256_set1_epi8((char)0xF0)), _mm256_set1_epi8(0x30));
+		} else {
+			digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+					_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+			l = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+			alpha = _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8('a' - 1)),
+					_mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), l));
+			valid = _mm256_or_si256(digit, alpha);
+			d = _mm256_blendv_epi8(_mm256_sub_epi8(l, _mm256_set1_epi8('a' - 10)), d, digit);
+		}
+		if (_mm256_movemask_epi8(valid) != -1)
+			break;
+		//ֽںϲΪһֽڣhi * 16 + lo
+		d = _mm256_maddubs_epi16(d, _mm256_set1_epi16(0x0110));
+		d = _mm256_packus_epi16(d, d);
+		d = _mm256_permute4x64_epi64(d, 0x08);
+		_mm_storeu_si128((__m128i *)bcd, _mm256_castsi256_si128(d));
+	}
+	return k;
+}
+#endif
+
+/**
+ * @brief ȡֽڣߵͰֽڶֵ
+ * 
+ * @param flags תδABC_FCHʱַΪ'0'
+ * @param fch ַ
+ * 
+ * @return ֽڣַǷ-1
+ */
+static int fill_byte(const U8 flags, const S8 fch)
+{
+	U8 ch = asc2nibble((flags & ABC_FCH) ? fch : '0', 0);
+
+	if (ch == 0xFF)
+		return -1;
+	return ch | ch << 4;
+}
+
+/**
+ * @brief asc2bcdxʵֽ֣ںָɵȡá
+ *        ABC_FILLֻת򣬴󻺴治дһ飻
+ *        תʧʱδдĽֽͬڣĽһ¡
+ * 
+ * @param fill ֽڣ-1ʾַǷ
+ * @param level ָ
+ * @param bad ǿʱǷַʧܻдһǷַλá
  * 
  * @return תBCD泤ȣתʧܷظ
  */
-S16 asc2bcdx(const S8 *asc_buf, const U16 asc_len, U8 *bcd_buf, const U16 bcd_len, const U8 flags, .../* const S8 fch */)
+static ssize_t asc2bcd_conv(const U8 *asc, const size_t asc_len, U8 *bcd_buf, const size_t bcd_len, const U8 flags, const int fill, const int level, size_t *bad)
 {
-	S8 fch = '0';
-	S16 i, conv_len = 0;
-	U8 ch, ch1, ch2;
-	va_list ap;
+	size_t conv_len = 0, out_len = asc_len - (asc_len >> 1);
+	U8 ch, ch1, ch2, num = flags & ABC_NUM, *end;
+	size_t i = 0, k = 0, n = asc_len;
 
-	if (!asc_buf || !bcd_buf) {
+	if (!asc || !bcd_buf) {
 		errno = EBADF;
 		return -1;
 	}
 	//жBCDǷ㹻		//* 4bit bcd = 8bit asc
-	if ((bcd_len << 1) < asc_len) {
+	if (bcd_len < out_len) {
 		errno = ENOMEM;
 		return -1;
 	}
-	//Ҫַָȡַ
-	if (flags & ABC_FCH) {
-		va_start(ap, flags);
-		fch = va_arg(ap, int);
-		//printf("fch = %x\n", fch);
-		va_end(ap);
-	}
-	//ʽ
-	if (fch >= 'a' && fch <= 'f') {
-		ch2 = fch - 'a' + 10;
-	} else if (fch >= 'A' && fch <= 'F') {
-		ch2 = fch - 'A' + 10;
-	} else if (fch >= '0' && fch <= '9') {
-		ch2 = fch - '0';
-	} else {
+	if (fill < 0) {
 		errno = EINVAL;
 		return -1;
 	}
-	ch2 |= ch2 << 4;
-	//ҪBCD棬
+	ch2 = fill;
+	//ҪBCD棬Ĳ
 	if (flags & ABC_FILL) {
-		memset(bcd_buf, ch2, bcd_len);
-	}
-	//ǰںĲͬ
-	ch1 = 0x55;
-	if (flags & ABC_FORE) {
-		if (flags & ABC_FILL) {
-			bcd_buf += bcd_len - ((asc_len + 1) >> 1);
-		}
-		if (asc_len & 0x01) {
-			ch1 = ch2 & 0x0F;
-		}
-	}
-	//תַ
-	for (i = 0; i < asc_len; asc_buf++, i++) {
-		if (flags & ABC_NUM) {
-			if (*asc_buf >= '0' && *asc_buf <= '?') {
-				ch = *asc_buf - '0';
-			} else {
-				errno = EINVAL;
-				return -1;
-			}
+		if (flags & ABC_FORE) {
+			memset(bcd_buf, ch2, bcd_len - out_len);
+			bcd_buf += bcd_len - out_len;
 		} else {
-			if (*asc_buf >= 'a' && *asc_buf <= 'f') {
-				ch = *asc_buf - 'a' + 10;
-			} else if (*asc_buf >= 'A' && *asc_buf <= 'F') {
-				ch = *asc_buf - 'A' + 10;
-			} else if (*asc_buf >= '0' && *asc_buf <= '9') {
-				ch = *asc_buf - '0';
-			} else {
-				errno = EINVAL;
-				return -1;
-			}
+			memset(bcd_buf + out_len, ch2, bcd_len - out_len);
 		}
-		if (ch1 == 0x55) {
-			ch1 = ch;
-		} else {
-			*bcd_buf++ = ch1 << 4 | ch;	//ǰ
-			conv_len++;
-			ch1 = 0x55;
+	}
+	end = bcd_buf + out_len;
+	//ǰ䣺ʱһַֽһֽ
+	if ((flags & ABC_FORE) && (asc_len & 0x01)) {
+		if ((ch = asc2nibble(*asc, num)) == 0xFF)
+			goto ERR;
+		*bcd_buf++ = (ch2 & 0x0F) << 4 | ch;
+		conv_len++;
+		i = 1;
+	}
+	//ɶתַ·ǷַĿɱ·Ӹô
+#ifdef BYTEO_X86
+	switch (level) {
+	case BYTEO_AVX2:
+		k = asc2bcd_avx2(asc + i, (n - i) >> 1, bcd_buf, num);
+		break;
+	case BYTEO_SSE2:
+		k = asc2bcd_sse2(asc + i, (n - i) >> 1, bcd_buf, num);
+		break;
+	}
+#endif
+	i += k << 1;
+	bcd_buf += k;
+	conv_len += k;
+	for ( ; i + 1 < n; i += 2) {
+		if ((ch = asc2nibble(asc[i], num)) == 0xFF)
+			goto ERR;
+		if ((ch1 = asc2nibble(asc[i + 1], num)) == 0xFF) {
+			i++;
+			goto ERR;
 		}
+		*bcd_buf++ = ch << 4 | ch1;
+		conv_len++;
 	}
-	if (ch1 != 0x55) {
-		*bcd_buf = ch1 << 4 | (ch2 & 0x0F);	//
+	//
+	if (i < n) {
+		if ((ch = asc2nibble(asc[i], num)) == 0xFF)
+			goto ERR;
+		*bcd_buf = ch << 4 | (ch2 & 0x0F);
 		conv_len++;
 	}
 	if (flags & ABC_FILL) {
@@ -119,67 +286,306 @@ S16 asc2bcdx(const S8 *asc_buf, const U16 asc_len, U8 *bcd_buf, const U16 bcd_le
 	} else {
 		return conv_len;
 	}
+
+ERR:
+	if (flags & ABC_FILL) {
+		memset(bcd_buf, ch2, end - bcd_buf);
+	}
+	if (bad) {
+		*bad = i;
+	}
+	errno = EINVAL;
+	return -1;
 }
 
 /**
- * @brief תBCDΪASCַ
- *				BCDʹasc2bcdxתġ
+ * @brief תASCַΪBCD棬ȲU16ơ
+ *        *lһ˳һ飬ÿֻֽдһΣСֿ顣
  * 
+ * @param asc_buf ASCַ
+ * @param asc_len ASCַȡ
  * @param bcd_buf BCDָ롣
  * @param bcd_len BCD泤ȡ
+ * @param flags תͬasc2bcdx
+ *        ... fch ֵתABC_FCHøֵ
+ * 
+ * @return תBCD泤ȣתʧܷظ
+ */
+ssize_t asc2bcdxl(const S8 *asc_buf, const size_t asc_len, U8 *bcd_buf, const size_t bcd_len, const U8 flags, .../* const S8 fch */)
+{
+	S8 fch = '0';
+	va_list ap;
+
+	if (flags & ABC_FCH) {
+		va_start(ap, flags);
+		fch = va_arg(ap, int);
+		va_end(ap);
+	}
+	return asc2bcd_conv((const U8 *)asc_buf, asc_len, bcd_buf, bcd_len, flags, fill_byte(flags, fch), byteo_cpu(), NULL);
+}
+
+/**
+ * @brief У鲢תASCַΪBCD棬һαɣҪȵisxdigits/isdigits
+ * 
  * @param asc_buf ASCַ
  * @param asc_len ASCַȡ
- * @param flags ת(0, ABC_NUM, ABC_FORE, ABC_FILL, ABC_FCH)еһֵֵ
- *        ... fch ֵתABC_FCHøֵֵASCַ(0-9 a-f A-F)Χڡ
+ * @param bcd_buf BCDָ롣
+ * @param bcd_len BCD泤ȡ
+ * @param bad ַǷʱдһǷַλãΪա
+ * @param flags תͬasc2bcdx
+ *        ... fch ֵתABC_FCHøֵ
  * 
- * @return תASCַȣתʧܷظ
+ * @return תBCD泤ȣתʧܷظַǷʱerrnoΪEINVAL
  */
-S16 bcd2ascx(const U8 *bcd_buf, const U16 bcd_len, S8 *asc_buf, const U16 asc_len, const U8 flags, .../* const S8 fch */)
+ssize_t asc2bcdxv(const S8 *asc_buf, const size_t asc_len, U8 *bcd_buf, const size_t bcd_len, size_t *bad, const U8 flags, .../* const S8 fch */)
 {
 	S8 fch = '0';
-	S16 i = 0, j, conv_len;
-	U8 ch1, ch2;
 	va_list ap;
-	
-	if (!asc_buf || !bcd_buf) {
-		errno = EBADF;
+
+	if (flags & ABC_FCH) {
+		va_start(ap, flags);
+		fch = va_arg(ap, int);
+		va_end(ap);
+	}
+	return asc2bcd_conv((const U8 *)asc_buf, asc_len, bcd_buf, bcd_len, flags, fill_byte(flags, fch), byteo_cpu(), bad);
+}
+
+/**
+ * @brief size_t汾תխΪS16ΧʱERANGE
+ * 
+ * @param ret ת
+ * 
+ * @return תS16Χ-1
+ */
+static S16 abc_ret16(const ssize_t ret)
+{
+	if (ret > SHRT_MAX) {
+		errno = ERANGE;
 		return -1;
 	}
+	return ret;
+}
+
+/**
+ * @brief תASCַΪBCD档
+ * 
+ * @param asc_buf ASCַ
+ * @param asc_len ASCַȡ
+ * @param bcd_buf BCDָ롣
+ * @param bcd_len BCD泤ȡ
+ * @param flags ת(0 | ABC_NUM | ABC_FORE | ABC_FILL | ABC_FCH)еһֵֵ
+ *        ... fch ֵתABC_FCHøֵֵASCַ(0-9 a-f A-F)Χڡ
+ * 
+ * @return תBCD泤ȣתʧܷظ32767ʱ-1ERANGEӦasc2bcdxl
+ */
+S16 asc2bcdx(const S8 *asc_buf, const U16 asc_len, U8 *bcd_buf, const U16 bcd_len, const U8 flags, .../* const S8 fch */)
+{
+	S8 fch = '0';
+	va_list ap;
+
 	//Ҫַָȡַ
 	if (flags & ABC_FCH) {
 		va_start(ap, flags);
 		fch = va_arg(ap, int);
 		va_end(ap);
 	}
-	//ʽ
-	if (fch >= 'a' && fch <= 'f') {
-		ch2 = fch - 'a' + 10;
-	} else if (fch >= 'A' && fch <= 'F') {
-		ch2 = fch - 'A' + 10;
-	} else if (fch >= '0' && fch <= '9') {
-		ch2 = fch - '0';
-	} else {
+	return abc_ret16(asc2bcd_conv((const U8 *)asc_buf, asc_len, bcd_buf, bcd_len, flags, fill_byte(flags, fch), byteo_cpu(), NULL));
+}
+
+/** @brief ֽڵASCַӳǰ16ĬϷΧ16ABC_NUM */
+static const U8 nibble2asc[32] = {
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', ':', ';', '<', '=', '>', '?'
+};
+
+#ifdef BYTEO_X86
+/**
+ * @brief SSE2ÿչ16ֽBCDΪ32ASCַ
+ * 
+ * @param bcd BCD档
+ * @param nbytes BCDֽ
+ * @param asc ASC档
+ * @param num 0ʱABC_NUMΧ
+ * 
+ * @return չֽ
+ */
+__attribute__((target("sse2")))
+static size_t bcd2asc_sse2(const U8 *bcd, size_t nbytes, U8 *asc, const U8 num)
+{
+	size_t k;
+	__m128i b, hi, lo, m = _mm_set1_epi8(0x0F);
+
+	for (k = 0; k + 16 <= nbytes; k += 16, bcd += 16, asc += 32) {
+		b = _mm_loadu_si128((const __m128i *)bcd);
+		hi = _mm_and_si128(_mm_srli_epi16(b, 4), m);
+		lo = _mm_and_si128(b, m);
+		b = _mm_unpacklo_epi8(hi, lo);
+		hi = _mm_unpackhi_epi8(hi, lo);
+		if (num) {
+			b = _mm_add_epi8(b, _mm_set1_epi8('0'));
+			hi = _mm_add_epi8(hi, _mm_set1_epi8('0'));
+		} else {
+			//9İֽټ'A' - '9' - 1
+			b = _mm_add_epi8(_mm_add_epi8(b, _mm_set1_epi8('0')),
+					_mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '9' - 1)));
+			hi = _mm_add_epi8(_mm_add_epi8(hi, _mm_set1_epi8('0')),
+					_mm_and_si128(_mm_cmpgt_epi8(hi, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '9' - 1)));
+		}
+		_mm_storeu_si128((__m128i *)asc, b);
+		_mm_storeu_si128((__m128i *)(asc + 16), hi);
+	}
+	return k;
+}
+
+/**
+ * @brief AVX2ÿչ16ֽBCDΪ32ASCַòָӳַ
+ * 
+ * @param bcd BCD档
+ * @param nbytes BCDֽ
+ * @param asc ASC档
+ * @param num 0ʱABC_NUMΧ
+ * 
+ * @return չֽ
+ */
+__attribute__((target("avx2")))
+static size_t bcd2asc_avx2(const U8 *bcd, size_t nbytes, U8 *asc, const U8 num)
+{
+	size_t k;
+	__m256i x, table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(nibble2asc + (num ? 16 : 0))));
+
+	for (k = 0; k + 16 <= nbytes; k += 16, bcd += 16, asc += 32) {
+		//ÿֽչΪ16λֽڷŸֽ߰ڣֽڷŵͰֽ
+		x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)bcd));
+		x = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi16(x, 4), _mm256_slli_epi16(x, 8)), _mm256_set1_epi16(0x0F0F));
+		_mm256_storeu_si256((__m256i *)asc, _mm256_shuffle_epi8(table, x));
+	}
+	return k;
+}
+
+/**
+ * @brief SSE2㻺ͷchֽ
+ */
+__attribute__((target("sse2")))
+static size_t bytes_span_sse2(const U8 *p, size_t n, const U8 ch)
+{
+	size_t k;
+	int m;
+
+	for (k = 0; k + 16 <= n; k += 16) {
+		m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + k)), _mm_set1_epi8(ch))) ^ 0xFFFF;
+		if (m)
+			return k + __builtin_ctz(m);
+	}
+	while (k < n && p[k] == ch)
+		k++;
+	return k;
+}
+
+/**
+ * @brief SSE2㻺βchֽ
+ */
+__attribute__((target("sse2")))
+static size_t bytes_rspan_sse2(const U8 *p, size_t n, const U8 ch)
+{
+	size_t k;
+	int m;
+
+	for (k = 0; k + 16 <= n; k += 16) {
+		m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + n - k - 16)), _mm_set1_epi8(ch))) ^ 0xFFFF;
+		if (m)
+			return k + __builtin_clz(m) - 16;
+	}
+	while (k < n && p[n - k - 1] == ch)
+		k++;
+	return k;
+}
+#endif
+
+/**
+ * @brief 㻺ͷchֽ
+ * 
+ * @param p 뻺档
+ * @param n 뻺泤ȡ
+ * @param ch Ƚֽڡ
+ * 
+ * @return ȵֽ
+ */
+static size_t bytes_span(const U8 *p, size_t n, const U8 ch)
+{
+	size_t k = 0;
+
+#ifdef BYTEO_X86
+	if (byteo_cpu() != BYTEO_SCALAR)
+		return bytes_span_sse2(p, n, ch);
+#endif
+	while (k < n && p[k] == ch)
+		k++;
+	return k;
+}
+
+/**
+ * @brief 㻺βchֽ
+ * 
+ * @param p 뻺档
+ * @param n 뻺泤ȡ
+ * @param ch Ƚֽڡ
+ * 
+ * @return ȵֽ
+ */
+static size_t bytes_rspan(const U8 *p, size_t n, const U8 ch)
+{
+	size_t k = 0;
+
+#ifdef BYTEO_X86
+	if (byteo_cpu() != BYTEO_SCALAR)
+		return bytes_rspan_sse2(p, n, ch);
+#endif
+	while (k < n && p[n - k - 1] == ch)
+		k++;
+	return k;
+}
+
+/**
+ * @brief bcd2ascxʵֽ֣ںָɵȡá
+ * 
+ * @param fill ֽڣ-1ʾַǷ
+ * @param level ָ
+ * 
+ * @return תASCַȣתʧܷظ
+ */
+static ssize_t bcd2asc_conv(const U8 *bcd_buf, const size_t bcd_len, S8 *asc_buf, const size_t asc_len, const U8 flags, const int fill, const int level)
+{
+	size_t conv_len;
+	U8 ch2, *asc = (U8 *)asc_buf;
+	const U8 *table = nibble2asc + ((flags & ABC_NUM) ? 16 : 0);
+	size_t k = 0, n, odd = 0, skip;
+
+	if (!asc_buf || !bcd_buf) {
+		errno = EBADF;
+		return -1;
+	}
+	if (fill < 0) {
 		errno = EINVAL;
 		return -1;
 	}
-	ch2 |= ch2 << 4;
+	ch2 = fill;
 	//ʵתʼλúݳ
+	n = bcd_len;
 	conv_len = bcd_len << 1;
 	if (flags & ABC_FILL) {
 		if (flags & ABC_FORE) {
-			while (conv_len > 0 && *bcd_buf == ch2) {
-				bcd_buf++;
-				conv_len -= 2;
-			}
-			if ((*bcd_buf & 0xf0) == (ch2 & 0xf0)) {
-				i = 1;
+			skip = bytes_span(bcd_buf, n, ch2);
+			bcd_buf += skip;
+			n -= skip;
+			conv_len -= skip << 1;
+			if (n > 0 && (*bcd_buf & 0xf0) == (ch2 & 0xf0)) {
+				odd = 1;
 				conv_len --;
 			}
 		} else {
-			while (conv_len > 0 && *(bcd_buf + (conv_len >> 1) - 1) == ch2) {
-				conv_len -= 2;
-			}
-			if ((*(bcd_buf + (conv_len >> 1) - 1) & 0x0f) == (ch2 & 0x0f)) {
+			n -= bytes_rspan(bcd_buf, n, ch2);
+			conv_len = n << 1;
+			if (n > 0 && (bcd_buf[n - 1] & 0x0f) == (ch2 & 0x0f)) {
 				conv_len --;
 			}
 		}
@@ -202,18 +608,146 @@ S16 bcd2ascx(const U8 *bcd_buf, const U16 bcd_len, S8 *asc_buf, const U16 asc_le
 		return -1;
 	}
 
-	//תַ				
-	j = conv_len + i;		
-	for ( ; i < j; i++, asc_buf++) {
-		ch1 = (i & 0x01) ? (*bcd_buf++ & 0x0f) : (*bcd_buf >> 4);
-		if (flags & ABC_NUM) {
-			ch1 += '0';
+	//תַʼȡͰֽڣֽչʣһֽ߰
+	n = conv_len;
+	if (odd && n > 0) {
+		*asc++ = table[*bcd_buf++ & 0x0f];
+		n--;
+	}
+#ifdef BYTEO_X86
+	switch (level) {
+	case BYTEO_AVX2:
+		k = bcd2asc_avx2(bcd_buf, n >> 1, asc, flags & ABC_NUM);
+		break;
+	case BYTEO_SSE2:
+		k = bcd2asc_sse2(bcd_buf, n >> 1, asc, flags & ABC_NUM);
+		break;
+	}
+#endif
+	for ( ; k < (n >> 1); k++) {
+		asc[k << 1] = table[bcd_buf[k] >> 4];
+		asc[(k << 1) + 1] = table[bcd_buf[k] & 0x0f];
+	}
+	if (n & 0x01) {
+		asc[n - 1] = table[bcd_buf[k] >> 4];
+	}
+	return conv_len;
+}
+
+/**
+ * @brief תBCDΪASCַȲU16ơ
+ * 
+ * @param bcd_buf BCDָ롣
+ * @param bcd_len BCD泤ȡ
+ * @param asc_buf ASCַ
+ * @param asc_len ASCַȡ
+ * @param flags תͬbcd2ascx
+ *        ... fch ֵתABC_FCHøֵ
+ * 
+ * @return תASCַȣתʧܷظ
+ */
+ssize_t bcd2ascxl(const U8 *bcd_buf, const size_t bcd_len, S8 *asc_buf, const size_t asc_len, const U8 flags, .../* const S8 fch */)
+{
+	S8 fch = '0';
+	va_list ap;
+
+	if (flags & ABC_FCH) {
+		va_start(ap, flags);
+		fch = va_arg(ap, int);
+		va_end(ap);
+	}
+	return bcd2asc_conv(bcd_buf, bcd_len, asc_buf, asc_len, flags, fill_byte(flags, fch), byteo_cpu());
+}
+
+/**
+ * @brief תBCDΪASCַ
+ *				BCDʹasc2bcdxתġ
+ * 
+ * @param bcd_buf BCDָ롣
+ * @param bcd_len BCD泤ȡ
+ * @param asc_buf ASCַ
+ * @param asc_len ASCַȡ
+ * @param flags ת(0, ABC_NUM, ABC_FORE, ABC_FILL, ABC_FCH)еһֵֵ
+ *        ... fch ֵתABC_FCHøֵֵASCַ(0-9 a-f A-F)Χڡ
+ * 
+ * @return תASCַȣתʧܷظ32767ʱ-1ERANGEӦbcd2ascxl
+ */
+S16 bcd2ascx(const U8 *bcd_buf, const U16 bcd_len, S8 *asc_buf, const U16 asc_len, const U8 flags, .../* const S8 fch */)
+{
+	S8 fch = '0';
+	va_list ap;
+
+	//Ҫַָȡַ
+	if (flags & ABC_FCH) {
+		va_start(ap, flags);
+		fch = va_arg(ap, int);
+		va_end(ap);
+	}
+	return abc_ret16(bcd2asc_conv(bcd_buf, bcd_len, asc_buf, asc_len, flags, fill_byte(flags, fch), byteo_cpu()));
+}
+
+/**
+ * @brief תֶΣÿֶεĽдreterr
+ *        ֶεַͬʱֻһΣָֻȡһΡ
+ * 
+ * @param fields ֶ顣
+ * @param count ֶθ
+ * @param to_bcd 0ʱasc2bcdxתbcd2ascxת
+ * 
+ * @return תʧֶܵθ
+ */
+static U16 abc_fields(ABC_FIELD *fields, const U16 count, const int to_bcd)
+{
+	ABC_FIELD *f;
+	U16 i, failed = 0;
+	int fill = 0, key = -1, level = byteo_cpu();
+	S8 fch;
+
+	for (i = 0, f = fields; i < count; i++, f++) {
+		fch = (f->flags & ABC_FCH) ? f->fch : '0';
+		if ((U8)fch != key) {
+			key = (U8)fch;
+			fill = fill_byte(ABC_FCH, fch);
+		}
+		if (to_bcd) {
+			f->ret = abc_ret16(asc2bcd_conv((const U8 *)f->src, f->src_len, (U8 *)f->dst, f->dst_len, f->flags, fill, level, NULL));
 		} else {
-			ch1 += (ch1 > 9) ? ('A' - 10) : '0';
+			f->ret = abc_ret16(bcd2asc_conv((const U8 *)f->src, f->src_len, (S8 *)f->dst, f->dst_len, f->flags, fill, level));
+		}
+		if (f->ret < 0) {
+			f->err = errno;
+			failed++;
+		} else {
+			f->err = 0;
 		}
-		*asc_buf = ch1;
 	}
-	return conv_len;
+	return failed;
+}
+
+/**
+ * @brief תASCַΪBCD棬ÿֶΰasc2bcdx
+ * 
+ * @param fields ֶ飬srcΪASCַdstΪBCD档
+ * @param count ֶθ
+ * 
+ * @return תʧֶܵθֶνreterr
+ */
+U16 asc2bcds(ABC_FIELD *fields, const U16 count)
+{
+	return abc_fields(fields, count, 1);
+}
+
+/**
+ * @brief תBCDΪASCַÿֶΰbcd2ascx
+ * 
+ * @param fields ֶ飬srcΪBCD棬dstΪASCַ
+ * @param count ֶθ
+ * 
+ * @return תʧֶܵθֶνreterr
+ */
+U16 bcd2ascs(ABC_FIELD *fields, const U16 count)
+{
+	return abc_fields(fields, count, 0);
 }
 
 /**
@@ -242,93 +776,389 @@ S8 *atrim(S8 *str)
  * 
  * @param str ַ
  * 
- * @return ضϺַָ롣
+ * @return ضϺַָ롣
+ */
+S8 *ltrim(S8 *str)
+{
+	while (*str && isspace(*str)) str++;
+	return str;
+}
+
+/**
+ * @brief ضַҿո
+ * 
+ * @param str ַ
+ * 
+ * @return ضϺַָ롣
+ */
+S8 *rtrim(S8 *str)
+{
+	S8 *p;
+	p = str + strlen(str) - 1;
+	while (p > str && isspace(*p)) {
+		*p = '\0';
+		p--;
+	}
+	return str;
+}
+
+/**
+ * @brief ضַҿո
+ * 
+ * @param str ַ
+ * 
+ * @return ضϺַָ롣
+ */
+S8 *trim(S8 *str)
+{
+	S8 *p;
+	p = ltrim(str);
+	p = rtrim(p);
+	return p;
+}
+
+/**
+ * @brief ַǷǻз'\r','\n'
+ * 
+ * @param c ַ
+ * 
+ * @return truefalse
+ */
+bool isbreak(const S8 c)
+{
+	return ((c) == '\r' || (c) == '\n') ? true: false;
+}
+
+#ifdef BYTEO_X86
+/**
+ * @brief SSE2ַͷ֣ʮƣַĸÿμ16ַ
+ * 
+ * @return ǷַʱΪλãΪѼַ16ı
+ */
+__attribute__((target("sse2")))
+static size_t span_sse2(const U8 *s, const size_t n, const int hex)
+{
+	size_t i;
+	__m128i c, l, ok;
+	int m;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		c = _mm_loadu_si128((const __m128i *)(s + i));
+		ok = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+		if (hex) {
+			l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+			ok = _mm_or_si128(ok, _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(l, _mm_set1_epi8('f' + 1))));
+		}
+		if ((m = _mm_movemask_epi8(ok) ^ 0xFFFF) != 0)
+			return i + __builtin_ctz(m);
+	}
+	return i;
+}
+
+/**
+ * @brief AVX2ַͷ֣ʮƣַĸÿμ32ַ
+ * 
+ * @return ǷַʱΪλãΪѼַ32ı
+ */
+__attribute__((target("avx2")))
+static size_t span_avx2(const U8 *s, const size_t n, const int hex)
+{
+	size_t i;
+	__m256i c, l, ok;
+	unsigned int m;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		c = _mm256_loadu_si256((const __m256i *)(s + i));
+		ok = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+		if (hex) {
+			l = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+			ok = _mm256_or_si256(ok, _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8('a' - 1)),
+					_mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), l)));
+		}
+		if ((m = ~(unsigned int)_mm256_movemask_epi8(ok)) != 0)
+			return i + __builtin_ctz(m);
+	}
+	return i;
+}
+#endif
+
+/**
+ * @brief ַͷ֣ʮƣַĸ
+ * 
+ * @param s ַ
+ * @param n ַȡ
+ * @param hex 0ʱʮַ
+ * 
+ * @return һǷַλãȫϷn
+ */
+static size_t span_digits(const U8 *s, const size_t n, const int hex)
+{
+	size_t i = 0;
+
+#ifdef BYTEO_X86
+	switch (byteo_cpu()) {
+	case BYTEO_AVX2:
+		i = span_avx2(s, n, hex);
+		break;
+	case BYTEO_SSE2:
+		i = span_sse2(s, n, hex);
+		break;
+	}
+#endif
+	//·ͣڷǷַʱһμ鼴˳
+	for ( ; i < n; i++) {
+		if ((U8)(s[i] - '0') < 10 || (hex && (U8)((s[i] | 0x20) - 'a') < 6))
+			continue;
+		break;
+	}
+	return i;
+}
+
+/**
+ * @brief ַͷַ0-9ĸlocaleӰ졣
+ * 
+ * @param s ַ
+ * @param nbytes ַȡ
+ * 
+ * @return һַλãȫַnbytes
+ */
+size_t spandigits(const S8 *s, const size_t nbytes)
+{
+	return span_digits((const U8 *)s, nbytes, 0);
+}
+
+/**
+ * @brief ַͷʮַ0-9 a-f A-FĸlocaleӰ졣
+ * 
+ * @param s ַ
+ * @param nbytes ַȡ
+ * 
+ * @return һʮַλãȫϷnbytes
+ */
+size_t spanxdigits(const S8 *s, const size_t nbytes)
+{
+	return span_digits((const U8 *)s, nbytes, 1);
+}
+
+/**
+ * @brief ַǷȫַ0-9
+ * 
+ * @param s ַ
+ * @param nbytes ַȡ
+ * 
+ * @return truefalse
+ */
+bool isdigitsl(const S8 *s, const size_t nbytes)
+{
+	return span_digits((const U8 *)s, nbytes, 0) == nbytes;
+}
+
+/**
+ * @brief ַǷȫַ0-9
+ * 
+ * @param s ַ
+ * @param nbytes ַȡ
+ * 
+ * @return truefalse
+ */
+bool isdigits(const S8 *s, const U16 nbytes)
+{
+	return span_digits((const U8 *)s, nbytes, 0) == nbytes;
+}
+
+/**
+ * @brief ַǷȫʮַ0-9a-f
+ * 
+ * @param s ַ
+ * @param nbytes ַȡ
+ * 
+ * @return truefalse
+ */
+bool isxdigitsl(const S8 *s, const size_t nbytes)
+{
+	return span_digits((const U8 *)s, nbytes, 1) == nbytes;
+}
+
+/**
+ * @brief ַǷȫʮַ0-9a-f
+ * 
+ * @param s ַ
+ * @param nbytes ַȡ
+ * 
+ * @return truefalse
+ */
+bool isxdigits(const S8 *s, const U16 nbytes)
+{
+	return span_digits((const U8 *)s, nbytes, 1) == nbytes;
+}
+
+/** @brief λ͡ */
+#define BITOP_AND 0
+#define BITOP_OR  1
+#define BITOP_XOR 2
+#define BITOP_NOT 3
+
+/**
+ * @brief ֽ㣬BITOP_NOTb
+ * 
+ * @return Ѵֽ
  */
-S8 *ltrim(S8 *str)
+static size_t bitop_bytes(U8 *d, const U8 *a, const U8 *b, const size_t n, const int op)
 {
-	while (*str && isspace(*str)) str++;
-	return str;
+	size_t i;
+
+	switch (op) {
+	case BITOP_AND:
+		for (i = 0; i < n; i++) d[i] = a[i] & b[i];
+		break;
+	case BITOP_OR:
+		for (i = 0; i < n; i++) d[i] = a[i] | b[i];
+		break;
+	case BITOP_XOR:
+		for (i = 0; i < n; i++) d[i] = a[i] ^ b[i];
+		break;
+	default:
+		for (i = 0; i < n; i++) d[i] = ~a[i];
+		break;
+	}
+	return n;
 }
 
 /**
- * @brief ضַҿո
- * 
- * @param str ַ
+ * @brief 64λ㣬memcpyдͱ⡣
  * 
- * @return ضϺַָ롣
+ * @return Ѵֽ8ı
  */
-S8 *rtrim(S8 *str)
+static size_t bitop_words(U8 *d, const U8 *a, const U8 *b, const size_t n, const int op)
 {
-	S8 *p;
-	p = str + strlen(str) - 1;
-	while (p > str && isspace(*p)) {
-		*p = '\0';
-		p--;
+	size_t i;
+	uint64_t x, y;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		memcpy(&x, a + i, 8);
+		if (op != BITOP_NOT)
+			memcpy(&y, b + i, 8);
+		switch (op) {
+		case BITOP_AND: x &= y; break;
+		case BITOP_OR:  x |= y; break;
+		case BITOP_XOR: x ^= y; break;
+		default:        x = ~x; break;
+		}
+		memcpy(d + i, &x, 8);
 	}
-	return str;
+	return i;
 }
 
+#ifdef BYTEO_X86
 /**
- * @brief ضַҿո
- * 
- * @param str ַ
+ * @brief SSE2ÿ16ֽڡ
  * 
- * @return ضϺַָ롣
+ * @return Ѵֽ16ı
  */
-S8 *trim(S8 *str)
+__attribute__((target("sse2")))
+static size_t bitop_sse2(U8 *d, const U8 *a, const U8 *b, const size_t n, const int op)
 {
-	S8 *p;
-	p = ltrim(str);
-	p = rtrim(p);
-	return p;
+	size_t i = 0;
+	__m128i x, y = _mm_set1_epi8(-1);
+
+	for ( ; i + 16 <= n; i += 16) {
+		x = _mm_loadu_si128((const __m128i *)(a + i));
+		if (op != BITOP_NOT)
+			y = _mm_loadu_si128((const __m128i *)(b + i));
+		switch (op) {
+		case BITOP_AND: x = _mm_and_si128(x, y); break;
+		case BITOP_OR:  x = _mm_or_si128(x, y); break;
+		default:        x = _mm_xor_si128(x, y); break;
+		}
+		_mm_storeu_si128((__m128i *)(d + i), x);
+	}
+	return i;
 }
 
 /**
- * @brief ַǷǻз'\r','\n'
- * 
- * @param c ַ
+ * @brief AVX2ÿ64ֽڡ
  * 
- * @return truefalse
+ * @return Ѵֽ32ı
  */
-bool isbreak(const S8 c)
+__attribute__((target("avx2")))
+static size_t bitop_avx2(U8 *d, const U8 *a, const U8 *b, const size_t n, const int op)
 {
-	return ((c) == '\r' || (c) == '\n') ? true: false;
+	size_t i = 0;
+	__m256i x0, x1, y0 = _mm256_set1_epi8(-1), y1 = y0;
+
+	for ( ; i + 64 <= n; i += 64) {
+		x0 = _mm256_loadu_si256((const __m256i *)(a + i));
+		x1 = _mm256_loadu_si256((const __m256i *)(a + i + 32));
+		if (op != BITOP_NOT) {
+			y0 = _mm256_loadu_si256((const __m256i *)(b + i));
+			y1 = _mm256_loadu_si256((const __m256i *)(b + i + 32));
+		}
+		switch (op) {
+		case BITOP_AND: x0 = _mm256_and_si256(x0, y0); x1 = _mm256_and_si256(x1, y1); break;
+		case BITOP_OR:  x0 = _mm256_or_si256(x0, y0); x1 = _mm256_or_si256(x1, y1); break;
+		default:        x0 = _mm256_xor_si256(x0, y0); x1 = _mm256_xor_si256(x1, y1); break;
+		}
+		_mm256_storeu_si256((__m256i *)(d + i), x0);
+		_mm256_storeu_si256((__m256i *)(d + i + 32), x1);
+	}
+	for ( ; i + 32 <= n; i += 32) {
+		x0 = _mm256_loadu_si256((const __m256i *)(a + i));
+		if (op != BITOP_NOT)
+			y0 = _mm256_loadu_si256((const __m256i *)(b + i));
+		switch (op) {
+		case BITOP_AND: x0 = _mm256_and_si256(x0, y0); break;
+		case BITOP_OR:  x0 = _mm256_or_si256(x0, y0); break;
+		default:        x0 = _mm256_xor_si256(x0, y0); break;
+		}
+		_mm256_storeu_si256((__m256i *)(d + i), x0);
+	}
+	return i;
 }
+#endif
 
 /**
- * @brief ַǷȫַ0-9
- * 
- * @param s ַ
- * @param nbytes ַȡ
+ * @brief ֽķɺȰ水ȶ룬
+ *        ٰ64λֽ֡δʣಿ֡
+ *        뻺ȫͬԭ㣩ܲص
  * 
- * @return truefalse
+ * @param d 档
+ * @param a 1档
+ * @param b 2棬BITOP_NOTʱȡַ㣬Ϊգɴa
+ * @param n С
+ * @param op ͡
  */
-bool isdigits(const S8 *s, const U16 nbytes)
+static void bitop(U8 *d, const U8 *a, const U8 *b, const size_t n, const int op)
 {
-	S16 i;
-	for (i = 0; i < nbytes; i++, s++) {
-		if (!isdigit(*s))
-			return false;
+	size_t i = 0, head;
+	int level = byteo_cpu();
+
+	//ֱ̻Ӱִ
+	if (n >= 64 && level != BYTEO_SCALAR) {
+		head = -(uintptr_t)d & ((level == BYTEO_AVX2 ? 32 : 16) - 1);
+		i = bitop_bytes(d, a, b, head, op);
+#ifdef BYTEO_X86
+		if (level == BYTEO_AVX2) {
+			i += bitop_avx2(d + i, a + i, b + i, n - i, op);
+		} else {
+			i += bitop_sse2(d + i, a + i, b + i, n - i, op);
+		}
+#endif
 	}
-	return true;
+	i += bitop_words(d + i, a + i, b + i, n - i, op);
+	bitop_bytes(d + i, a + i, b + i, n - i, op);
 }
 
 /**
- * @brief ַǷȫʮַ0-9a-f
- * 
- * @param s ַ
- * @param nbytes ַȡ
+ * @brief ֽ롣destԵb1b2ԭ㣩
  * 
- * @return truefalse
+ * @param dest 档
+ * @param b1 1档
+ * @param b2 2档
+ * @param nbytes 뻺С
  */
-bool isxdigits(const S8 *s, const U16 nbytes)
+void andsl(U8 *dest, const U8 *b1, const U8 *b2, const size_t nbytes)
 {
-	S16 i;
-	for (i = 0; i < nbytes; i++, s++) {
-		if (!isxdigit(*s))
-			return false;
-	}
-	return true;
+	bitop(dest, b1, b2, nbytes, BITOP_AND);
 }
 
 /**
@@ -341,10 +1171,20 @@ bool isxdigits(const S8 *s, const U16 nbytes)
  */
 void ands(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes)
 {
-	S16 i;
-	for (i = 0; i < nbytes; i++) {
-		*dest++ = *b1++ & *b2++;
-	}
+	bitop(dest, b1, b2, nbytes, BITOP_AND);
+}
+
+/**
+ * @brief ֽdestԵb1b2ԭ㣩
+ * 
+ * @param dest 档
+ * @param b1 1档
+ * @param b2 2档
+ * @param nbytes 뻺С
+ */
+void orsl(U8 *dest, const U8 *b1, const U8 *b2, const size_t nbytes)
+{
+	bitop(dest, b1, b2, nbytes, BITOP_OR);
 }
 
 /**
@@ -357,10 +1197,20 @@ void ands(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes)
  */
 void ors(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes)
 {
-	S16 i;
-	for (i = 0; i < nbytes; i++) {
-		*dest++ = *b1++ | *b2++;
-	}
+	bitop(dest, b1, b2, nbytes, BITOP_OR);
+}
+
+/**
+ * @brief ֽdestԵb1b2ԭ㣩
+ * 
+ * @param dest 档
+ * @param b1 1档
+ * @param b2 2档
+ * @param nbytes 뻺С
+ */
+void xorsl(U8 *dest, const U8 *b1, const U8 *b2, const size_t nbytes)
+{
+	bitop(dest, b1, b2, nbytes, BITOP_XOR);
 }
 
 /**
@@ -373,10 +1223,19 @@ void ors(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes)
  */
 void xors(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes)
 {
-	S16 i;
-	for (i = 0; i < nbytes; i++) {
-		*dest++ = *b1++ ^ *b2++;
-	}
+	bitop(dest, b1, b2, nbytes, BITOP_XOR);
+}
+
+/**
+ * @brief ֽȡdestԵb1ԭ㣩
+ * 
+ * @param dest 档
+ * @param b1 뻺档
+ * @param nbytes 뻺С
+ */
+void notsl(U8 *dest, const U8 *b1, const size_t nbytes)
+{
+	bitop(dest, b1, b1, nbytes, BITOP_NOT);
 }
 
 /**
@@ -388,64 +1247,413 @@ void xors(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes)
  */
 void nots(U8 *dest, const U8 *b1, const U16 nbytes)
 {
-	S16 i;
-	for (i = 0; i < nbytes; i++) {
-		*dest++ = ~*b1++;
+	bitop(dest, b1, b1, nbytes, BITOP_NOT);
+}
+
+#ifdef BYTEO_X86
+/**
+ * @brief AVX2໺ÿδ128ֽڣۼֵڼĴС
+ * 
+ * @return Ѵֽ
+ */
+__attribute__((target("avx2")))
+static size_t xorsn_avx2(U8 *dest, const U8 * const *bufs, const size_t count, const size_t n)
+{
+	size_t i, j;
+	__m256i x0, x1, x2, x3;
+	const U8 *p;
+
+	for (i = 0; i + 128 <= n; i += 128) {
+		p = bufs[0] + i;
+		x0 = _mm256_loadu_si256((const __m256i *)p);
+		x1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+		x2 = _mm256_loadu_si256((const __m256i *)(p + 64));
+		x3 = _mm256_loadu_si256((const __m256i *)(p + 96));
+		for (j = 1; j < count; j++) {
+			p = bufs[j] + i;
+			x0 = _mm256_xor_si256(x0, _mm256_loadu_si256((const __m256i *)p));
+			x1 = _mm256_xor_si256(x1, _mm256_loadu_si256((const __m256i *)(p + 32)));
+			x2 = _mm256_xor_si256(x2, _mm256_loadu_si256((const __m256i *)(p + 64)));
+			x3 = _mm256_xor_si256(x3, _mm256_loadu_si256((const __m256i *)(p + 96)));
+		}
+		_mm256_storeu_si256((__m256i *)(dest + i), x0);
+		_mm256_storeu_si256((__m256i *)(dest + i + 32), x1);
+		_mm256_storeu_si256((__m256i *)(dest + i + 64), x2);
+		_mm256_storeu_si256((__m256i *)(dest + i + 96), x3);
+	}
+	return i;
+}
+
+/**
+ * @brief SSE2໺ÿδ64ֽڡ
+ * 
+ * @return Ѵֽ
+ */
+__attribute__((target("sse2")))
+static size_t xorsn_sse2(U8 *dest, const U8 * const *bufs, const size_t count, const size_t n)
+{
+	size_t i, j;
+	__m128i x0, x1, x2, x3;
+	const U8 *p;
+
+	for (i = 0; i + 64 <= n; i += 64) {
+		p = bufs[0] + i;
+		x0 = _mm_loadu_si128((const __m128i *)p);
+		x1 = _mm_loadu_si128((const __m128i *)(p + 16));
+		x2 = _mm_loadu_si128((const __m128i *)(p + 32));
+		x3 = _mm_loadu_si128((const __m128i *)(p + 48));
+		for (j = 1; j < count; j++) {
+			p = bufs[j] + i;
+			x0 = _mm_xor_si128(x0, _mm_loadu_si128((const __m128i *)p));
+			x1 = _mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)(p + 16)));
+			x2 = _mm_xor_si128(x2, _mm_loadu_si128((const __m128i *)(p + 32)));
+			x3 = _mm_xor_si128(x3, _mm_loadu_si128((const __m128i *)(p + 48)));
+		}
+		_mm_storeu_si128((__m128i *)(dest + i), x0);
+		_mm_storeu_si128((__m128i *)(dest + i + 16), x1);
+		_mm_storeu_si128((__m128i *)(dest + i + 32), x2);
+		_mm_storeu_si128((__m128i *)(dest + i + 48), x3);
+	}
+	return i;
+}
+#endif
+
+/**
+ * @brief 水ֽһαɣcount - 1xors
+ *        destԵһ뻺棨ԭ㣩
+ * 
+ * @param dest 档
+ * @param bufs 뻺顣
+ * @param count 뻺Ϊ0ʱȫ0
+ * @param nbytes ÿĴС
+ */
+void xorsn(U8 *dest, const U8 * const *bufs, const size_t count, const size_t nbytes)
+{
+	size_t i = 0, j;
+	uint64_t x, y;
+
+	if (count == 0) {
+		memset(dest, 0, nbytes);
+		return;
+	}
+#ifdef BYTEO_X86
+	switch (byteo_cpu()) {
+	case BYTEO_AVX2:
+		i = xorsn_avx2(dest, bufs, count, nbytes);
+		break;
+	case BYTEO_SSE2:
+		i = xorsn_sse2(dest, bufs, count, nbytes);
+		break;
+	}
+#endif
+	for ( ; i + 8 <= nbytes; i += 8) {
+		memcpy(&x, bufs[0] + i, 8);
+		for (j = 1; j < count; j++) {
+			memcpy(&y, bufs[j] + i, 8);
+			x ^= y;
+		}
+		memcpy(dest + i, &x, 8);
+	}
+	for ( ; i < nbytes; i++) {
+		x = bufs[0][i];
+		for (j = 1; j < count; j++) {
+			x ^= bufs[j][i];
+		}
+		dest[i] = x;
 	}
 }
 
 #define HEXDUMP_SIZE (1024 * 20)
 S8 hexdump_buf[HEXDUMP_SIZE + 1];
 
-S8 *strcpyx(S8 *p, const S8 *s)
+/** @brief ʽʱıػС */
+#define HDX_CHUNK 4096
+/** @brief 󳤶ȣб11 + ʮ48 + ֺ1 + ASCַ16 + 1 */
+#define HDX_LINE 80
+
+static const S8 hex_digits[] = "0123456789ABCDEF";
+static const S8 hdx_cnum[] = "0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F  \n";
+static const S8 hdx_rule[] = "------------------------------------------------------------------\n";
+
+/** @brief ʽ״̬ڱػУ˲Žд */
+typedef struct {
+	HDX_WRITE write;
+	void *arg;
+	size_t len;
+	int err;
+	S8 buf[HDX_CHUNK];
+}HDX_SINK;
+
+/**
+ * @brief ѻеݽд
+ * 
+ * @return ɹ0дʧܷ-1
+ */
+static int hdx_flush(HDX_SINK *o)
+{
+	if (o->len && !o->err && o->write(o->arg, o->buf, o->len) != 0) {
+		o->err = 1;
+	}
+	o->len = 0;
+	return o->err ? -1 : 0;
+}
+
+/**
+ * @brief ȡHDX_LINEֽڵλá
+ */
+static S8 *hdx_reserve(HDX_SINK *o)
+{
+	if (HDX_CHUNK - o->len < HDX_LINE) {
+		hdx_flush(o);
+	}
+	return o->buf + o->len;
+}
+
+/**
+ * @brief ׷ӲHDX_LINEֽڵַ
+ */
+static void hdx_puts(HDX_SINK *o, const S8 *str, const size_t len)
+{
+	memcpy(hdx_reserve(o), str, len);
+	o->len += len;
+}
+
+/**
+ * @brief б"XXXXXXXXh: "ĬΪݵַĵ32λHDX_OFFSʱΪƫ
+ */
+static S8 *hdx_label(S8 *p, const U8 *addr, const size_t off, const U8 flags)
+{
+	U32 v = (flags & HDX_OFFS) ? (U32)off : (U32)(uintptr_t)addr;
+	int k;
+
+	for (k = 7; k >= 0; k--) {
+		p[k] = hex_digits[v & 0x0f];
+		v >>= 4;
+	}
+	p += 8;
+	*p++ = 'h';
+	*p++ = ':';
+	*p++ = ' ';
+	return p;
+}
+
+/**
+ * @brief cntֽڵ"XX "ʽ
+ */
+static S8 *hdx_hex(S8 *p, const U8 *buf, const size_t cnt)
 {
-	S16 l;
-	strcpy(p, s);
-	l = strlen(s);
-	p += l;
+	size_t j;
+
+	for (j = 0; j < cnt; j++) {
+		*p++ = hex_digits[buf[j] >> 4];
+		*p++ = hex_digits[buf[j] & 0x0f];
+		*p++ = ' ';
+	}
 	return p;
 }
 
-S8 *sprintfx(S8 *p, const S8 *s, ...)
+/**
+ * @brief cntֽڵASCַ'\0'ͿհַʾΪ'.'
+ */
+static S8 *hdx_asc(S8 *p, const U8 *buf, const size_t cnt)
 {
-	S16 l;
-	va_list args;
+	size_t j;
+	U8 c;
 
-	va_start(args, s);
-	vsprintf(p, s, args);
-	va_end(args);
-	l = strlen(p);
-	p += l;
+	for (j = 0; j < cnt; j++) {
+		c = buf[j];
+		*p++ = (c == '\0' || c == ' ' || (c >= '\t' && c <= '\r')) ? '.' : c;
+	}
 	return p;
 }
 
+/**
+ * @brief бǵķָߡ
+ */
+static void hdx_rule_line(HDX_SINK *o, const U8 flags)
+{
+	if (flags & HDX_LNUM) {
+		hdx_puts(o, hdx_rule, 11);
+	}
+	hdx_puts(o, hdx_rule, sizeof(hdx_rule) - 1);
+}
+
+/**
+ * @brief ʽֽʮִʽhexdumpxͬ
+ */
+static int hdx_dump(HDX_SINK *o, const U8 *buf, const size_t nbytes, const U8 flags)
+{
+	size_t i, cnt;
+	S8 *p, *q;
+
+	if (flags & HDX_CNUM) {
+		if (flags & HDX_LNUM) {
+			hdx_puts(o, "           ", 11);
+		}
+		hdx_puts(o, hdx_cnum, sizeof(hdx_cnum) - 1);
+		hdx_rule_line(o, flags);
+	}
+	if (flags & HDX_MUL) {
+		//ÿ16ֽڣһASCʱո
+		for (i = 0; i < nbytes && !o->err; i += 16) {
+			cnt = nbytes - i < 16 ? nbytes - i : 16;
+			p = q = hdx_reserve(o);
+			if (flags & HDX_LNUM) {
+				p = hdx_label(p, buf + i, i, flags);
+			}
+			p = hdx_hex(p, buf + i, cnt);
+			if (flags & HDX_ASC) {
+				memset(p, ' ', (16 - cnt) * 3);
+				p += (16 - cnt) * 3;
+				*p++ = ';';
+				p = hdx_asc(p, buf + i, cnt);
+			}
+			*p++ = '\n';
+			o->len += p - q;
+		}
+	} else if (nbytes > 0) {
+		//УȫʮASCٴͷһΣҪ⻺
+		if (flags & HDX_LNUM) {
+			p = hdx_reserve(o);
+			o->len += hdx_label(p, buf, 0, flags) - p;
+		}
+		for (i = 0; i < nbytes && !o->err; i += 16) {
+			cnt = nbytes - i < 16 ? nbytes - i : 16;
+			p = hdx_reserve(o);
+			o->len += hdx_hex(p, buf + i, cnt) - p;
+		}
+		if (flags & HDX_ASC) {
+			hdx_puts(o, ";", 1);
+			for (i = 0; i < nbytes && !o->err; i += 16) {
+				cnt = nbytes - i < 16 ? nbytes - i : 16;
+				p = hdx_reserve(o);
+				o->len += hdx_asc(p, buf + i, cnt) - p;
+			}
+		}
+		hdx_puts(o, "\n", 1);
+	}
+	if (flags & HDX_CNUM) {
+		hdx_rule_line(o, flags);
+	}
+	return hdx_flush(o);
+}
+
+/**
+ * @brief ʽֽʮִд룬Ȳơ
+ *        HDX_CHUNKֽڷֶνд
+ * 
+ * @param vbuf ֽ
+ * @param nbytes ֽȡ
+ * @param flags ʽ(0, HDX_MUL, HDX_LNUM, HDX_CNUM, HDX_ASC, HDX_OFFS)еһֵֵ
+ * @param write дط0ʱֹͣ
+ * @param arg дĲ
+ * 
+ * @return ɹ0дʧܷ-1
+ */
+int hexdumpw(const void *vbuf, const size_t nbytes, const U8 flags, HDX_WRITE write, void *arg)
+{
+	HDX_SINK o;
+
+	if (!vbuf || !write) {
+		errno = EINVAL;
+		return -1;
+	}
+	o.write = write;
+	o.arg = arg;
+	o.len = 0;
+	o.err = 0;
+	return hdx_dump(&o, (const U8 *)vbuf, nbytes, flags);
+}
+
+/** @brief д߻ʱλá */
+typedef struct {
+	S8 *out;
+	size_t size;
+	size_t len;
+}HDX_BUF;
+
+static int hdx_write_buf(void *arg, const S8 *data, size_t len)
+{
+	HDX_BUF *b = (HDX_BUF *)arg;
+	size_t n = 0;
+
+	if (b->len + 1 < b->size) {
+		n = b->size - 1 - b->len;
+		n = len < n ? len : n;
+		memcpy(b->out + b->len, data, n);
+	}
+	b->len += len;
+	return 0;
+}
+
+/**
+ * @brief ʽֽʮִ߻棬롣
+ *        snprintfͬضʱ'\0'β
+ * 
+ * @param out 档
+ * @param size С
+ * @param vbuf ֽ
+ * @param nbytes ֽȡ
+ * @param flags ʽͬhexdumpw
+ * 
+ * @return Ҫĳȣ'\0'ڵsizeʾضϣʧܷ-1
+ */
+ssize_t hexdumpn(S8 *out, const size_t size, const void *vbuf, const size_t nbytes, const U8 flags)
+{
+	HDX_BUF b;
+
+	b.out = out;
+	b.size = out ? size : 0;
+	b.len = 0;
+	if (hexdumpw(vbuf, nbytes, flags, hdx_write_buf, &b) != 0)
+		return -1;
+	if (b.size) {
+		out[b.len < b.size ? b.len : b.size - 1] = '\0';
+	}
+	return b.len;
+}
+
+static int hdx_write_file(void *arg, const S8 *data, size_t len)
+{
+	return fwrite(data, 1, len, (FILE *)arg) == len ? 0 : -1;
+}
+
+/**
+ * @brief ʽֽʮִļ룬Ȳơ
+ * 
+ * @param fp ļ
+ * @param vbuf ֽ
+ * @param nbytes ֽȡ
+ * @param flags ʽͬhexdumpw
+ * 
+ * @return ɹ0дļʧܷ-1
+ */
+int hexdumpf(FILE *fp, const void *vbuf, const size_t nbytes, const U8 flags)
+{
+	return hexdumpw(vbuf, nbytes, flags, hdx_write_file, fp);
+}
+
 /**
  * @brief ָʽֽʮִ
+ *        ȫֻУ룬߳ʹhexdumpn/hexdumpw/hexdumpf
  * 
  * @param vbuf ֽ
  * @param nbytes ֽȡ
- * @param flags ʽ(0, HDX_MUL, HDX_LNUM, HDX_CNUM, HDX_ASC, HDX_JOIN)еһֵֵ
+ * @param flags ʽ(0, HDX_MUL, HDX_LNUM, HDX_CNUM, HDX_ASC, HDX_JOIN, HDX_OFFS)еһֵֵ
  * @param ... ʽHDX_JOINøֵֵΪ0-255
  *  		  ע⣺printfsprintfȺĵǴӺǰȡֵ˳ҲӺǰ
  *  		  磺printf("%s%s", hexdumpx(buf, len, HDX_JOIN,
  *  		  1), hexdumpx(buf, len, HDX_JOIN, 0));
  * 
- * @return ʮִ쳣ؿա
+ * @return ʮִ쳣Сؿա
  */
 S8 *hexdumpx(void *vbuf, const U16 nbytes, const U8 flags, .../* const U8 hdx_ind */)
 {
-	S16 i, j;
 	U8 hdx_ind;
-	S8 *s, *e, *p, *sz = NULL, *psz = NULL;
+	S8 *s, *e;
+	ssize_t len;
 	va_list ap;
-	U8 *buf = (U8 *)vbuf;
-	
-	if (flags & HDX_ASC) {
-		sz = (S8 *)malloc(nbytes * sizeof(S8) + 1);
-		if (!sz)
-			return NULL;
-		psz = sz;
-	}
+
 	s = hexdump_buf;
 	e = hexdump_buf + sizeof(hexdump_buf);
 	if (flags & HDX_JOIN) {
@@ -454,59 +1662,19 @@ S8 *hexdumpx(void *vbuf, const U16 nbytes, const U8 flags, .../* const U8 hdx_in
 		va_end(ap);
 		while (hdx_ind--) {
 			s += strlen(s) + 1;
-			if (s > e) return NULL;
-		}
-	}
-	*s = '\0';
-	p = s;
-	
-	if (flags & HDX_CNUM) {
-		if (flags & HDX_LNUM) {
-			p = strcpyx(p, "           ");
-		}
-		p = strcpyx(p, "0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F  \n");
-		if (flags & HDX_LNUM) {
-			p = strcpyx(p, "-----------");
-		}
-		p = strcpyx(p, "------------------------------------------------------------------\n");
-	}
-	
-	for (i = 0; i < nbytes; buf++, i++) {
-		if (flags & HDX_LNUM) {
-			if (i == 0 || ((flags & HDX_MUL) && !(i & 0x0f))) {
-				p = sprintfx(p, "%08Xh: ", buf);
-			}
-		}
-		p = sprintfx(p, "%02X ", *buf);
-		if ((flags & HDX_ASC)) {
-			if (*buf == '\0' || isspace(*buf)) {
-				*psz++ = '.';
-			} else {
-				*psz++ = *buf;
+			if (s >= e) {
+				errno = ENOMEM;
+				return NULL;
 			}
-			if (i == nbytes - 1 || ((flags & HDX_MUL) && !((i & 0x0f) ^ 0x0f))) {
-				if (flags & HDX_MUL) {
-					for (j = 0; j < ((i & 0x0f) ^ 0x0f); j++)
-						p = strcpyx(p, "   ");
-				}
-				*psz = '\0';
-				p = sprintfx(p, ";%s", sz);
-				psz = sz;
-			}
-		}
-		if (i == nbytes - 1 || ((flags & HDX_MUL) && !((i & 0x0f) ^ 0x0f))) {
-			p = strcpyx(p, "\n");
-		}
-	}
-	if (flags & HDX_CNUM) {
-		if (flags & HDX_LNUM) {
-			p = strcpyx(p, "-----------");
 		}
-		p = strcpyx(p, "------------------------------------------------------------------\n");
 	}
-	if ((flags & HDX_ASC) && sz) {
-		free(sz);
+	len = hexdumpn(s, e - s, vbuf, nbytes, flags);
+	if (len < 0)
+		return NULL;
+	if (len >= e - s) {
+		*s = '\0';
+		errno = ENOMEM;
+		return NULL;
 	}
 	return s;
 }
-
@@ -10,6 +10,8 @@
 #define __BYTEO_H__
 
 #include "types.h"
+#include <stdio.h>
+#include <sys/types.h>
 
 /** @brief תASCַ(0-9 : ; < = > ?)Χڡ */
 #define ABC_NUM     0x01
@@ -30,6 +32,19 @@
 #define HDX_ASC     0x08
 /** @brief Ӷַⲿεøúʱ棬ԭеַ˸òҪע */
 #define HDX_JOIN    0x10
+/** @brief бʾʼƫݵַ */
+#define HDX_OFFS    0x20
+
+/**
+ * @brief ʮд
+ * 
+ * @param arg ߲
+ * @param data ݣ'\0'β
+ * @param len ݳȡ
+ * 
+ * @return ɹ0ط0ʱֹͣ
+ */
+typedef int (*HDX_WRITE)(void *arg, const S8 *data, size_t len);
 
 S16 asc2bcdx(const S8 *asc_buf, const U16 asc_len, U8 *bcd_buf, const U16 bcd_len, const U8 flags, .../* const S8 fch */);
 /**
@@ -44,6 +59,10 @@ S16 asc2bcdx(const S8 *asc_buf, const U16 asc_len, U8 *bcd_buf, const U16 bcd_le
  * @return תBCD泤ȣתʧܷظ
  */
 #define asc2bcd(a, b, c, d) asc2bcdx((a), (b), (c), (d), 0)
+/** @brief asc2bcdxsize_tȰ汾ڳ32Kݡ */
+ssize_t asc2bcdxl(const S8 *asc_buf, const size_t asc_len, U8 *bcd_buf, const size_t bcd_len, const U8 flags, .../* const S8 fch */);
+/** @brief У鲢תַǷʱͨbadصһǷַλá */
+ssize_t asc2bcdxv(const S8 *asc_buf, const size_t asc_len, U8 *bcd_buf, const size_t bcd_len, size_t *bad, const U8 flags, .../* const S8 fch */);
 S16 bcd2ascx(const U8 *bcd_buf, const U16 bcd_len, S8 *asc_buf, const U16 asc_len, const U8 flags, .../* const S8 fch */);
 /**
  * @brief תBCDΪASCַ
@@ -57,6 +76,23 @@ S16 bcd2ascx(const U8 *bcd_buf, const U16 bcd_len, S8 *asc_buf, const U16 asc_le
  * @return תASCַȣתʧܷظ
  */
 #define bcd2asc(a, b, c, d) bcd2ascx((a), (b), (c), (d), 0)
+/** @brief bcd2ascxsize_tȰ汾ڳ32Kݡ */
+ssize_t bcd2ascxl(const U8 *bcd_buf, const size_t bcd_len, S8 *asc_buf, const size_t asc_len, const U8 flags, .../* const S8 fch */);
+
+/** @brief תֶ(ABC_FIELD) */
+typedef struct {
+	const void *src;	/* 뻺 */
+	U16 src_len;		/* 볤 */
+	void *dst;			/*  */
+	U16 dst_len;		/* 泤 */
+	U8 flags;			/* תͬasc2bcdx/bcd2ascx */
+	S8 fch;				/* ַflagsABC_FCHʱЧ */
+	S16 ret;			/* תĳȣʧΪ */
+	int err;			/* ʧʱerrnoɹΪ0 */
+}ABC_FIELD;
+
+U16 asc2bcds(ABC_FIELD *fields, const U16 count);
+U16 bcd2ascs(ABC_FIELD *fields, const U16 count);
 
 S8 *atrim(S8 *str);
 S8 *ltrim(S8 *str);
@@ -66,11 +102,20 @@ S8 *trim(S8 *str);
 bool isbreak(const S8 c);
 bool isdigits(const S8 *s, const U16 nbytes);
 bool isxdigits(const S8 *s, const U16 nbytes);
+bool isdigitsl(const S8 *s, const size_t nbytes);
+bool isxdigitsl(const S8 *s, const size_t nbytes);
+size_t spandigits(const S8 *s, const size_t nbytes);
+size_t spanxdigits(const S8 *s, const size_t nbytes);
 
 void ands(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes);
 void ors(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes);
 void xors(U8 *dest, const U8 *b1, const U8 *b2, const U16 nbytes);
 void nots(U8 *dest, const U8 *b1, const U16 nbytes);
+void andsl(U8 *dest, const U8 *b1, const U8 *b2, const size_t nbytes);
+void orsl(U8 *dest, const U8 *b1, const U8 *b2, const size_t nbytes);
+void xorsl(U8 *dest, const U8 *b1, const U8 *b2, const size_t nbytes);
+void notsl(U8 *dest, const U8 *b1, const size_t nbytes);
+void xorsn(U8 *dest, const U8 * const *bufs, const size_t count, const size_t nbytes);
 
 S8 *hexdumpx(void *vbuf, const U16 nbytes, const U8 flags, .../* const U8 hdx_ind */);
 /**
@@ -94,5 +139,9 @@ S8 *hexdumpx(void *vbuf, const U16 nbytes, const U8 flags, .../* const U8 hdx_in
  */
 #define hexdump1(a, b) hexdumpx(a, (b), HDX_MUL | HDX_LNUM | HDX_CNUM | HDX_ASC)
 
+int hexdumpw(const void *vbuf, const size_t nbytes, const U8 flags, HDX_WRITE write, void *arg);
+ssize_t hexdumpn(S8 *out, const size_t size, const void *vbuf, const size_t nbytes, const U8 flags);
+int hexdumpf(FILE *fp, const void *vbuf, const size_t nbytes, const U8 flags);
+
 #endif /*__BYTEO_H__*/
 
@@ -1,54 +1,275 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <linux/fs.h>
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#endif
 #include "fileo.h"
 
-#define BUFFER_SIZE 1024
-#define DIR_MAXPATH 250
+/* д·ĻСͶ */
+#define BUFFER_SIZE (1024 * 1024)
+#define BUFFER_ALIGN 4096
+/* copy_file_range/sendfile󳤶 */
+#define COPY_CHUNK (1L << 30)
+//io_uringÿҵ۵ĻСCOPY_RING_MAXļžio_uring
+#define COPY_RING_BUF (64 * 1024)
+#define COPY_RING_MAX (1024 * 1024)
+#define COPY_RING_DEPTH 32
+#define COPY_RING_DEPTH_MAX 1024
+/* file_writevwritev */
+#define FILE_IO_IOV 64
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
 
-int copy_file(const char *from_file, const char *to_file)
+//ں˲ֻ֧ļϵͳ֧ʱЩ󣬿ɻһַʽ
+static int copy_unsupported(int err)
 {
-	int iRet = -1, size = 0, read_size, write_size, from_fd, to_fd;
-	byte buffer[BUFFER_SIZE], *p = NULL;
+	return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == EBADF || err == ETXTBSY || err == ENOTTY;
+}
+
+/**
+ * @brief дiovеȫݣEINTRͲд롣iovᱻ޸ġ
+ * 
+ * @return дֽʧܷ-1
+ */
+static ssize_t writev_full(int fd, struct iovec *iov, int cnt)
+{
+	ssize_t total = 0, n;
+
+	while (cnt > 0) {
+		if (iov->iov_len == 0) {
+			iov++;
+			cnt--;
+			continue;
+		}
+		if ((n = writev(fd, iov, cnt > IOV_MAX ? IOV_MAX : cnt)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		total += n;
+		while (cnt > 0 && (size_t)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			iov->iov_base = (byte *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	return total;
+}
+
+static ssize_t write_full(int fd, const void *data, size_t len)
+{
+	struct iovec iov;
+
+	iov.iov_base = (void *)data;
+	iov.iov_len = len;
+	return writev_full(fd, &iov, 1);
+}
+
+static S64 copy_fd_rw(int from_fd, int to_fd, S64 size)
+{
+	S64 iRet = -1;
+	ssize_t read_size;
+	byte *buffer = NULL;
+
+	if (posix_memalign((void **)&buffer, BUFFER_ALIGN, BUFFER_SIZE) != 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+	while ((read_size = read(from_fd, buffer, BUFFER_SIZE))) {
+		if (read_size == -1) {
+			if (errno == EINTR)
+				continue;
+			goto ERR;
+		}
+		if (write_full(to_fd, buffer, read_size) == -1) {
+			goto ERR;
+		}
+		size += read_size;
+	}
+	iRet = size;
+ERR:
+	free(buffer);
+	return iRet;
+}
+
+/**
+ * @brief γcopy_file_rangesendfileͶ뻺д
+ * sizeΪԴļСԤĿļΪ0ʱ/procµļֻöд
+ * 
+ * @return Ƶֽʧܷ-1
+ */
+static S64 copy_fd(int from_fd, int to_fd, off_t size)
+{
+	S64 copied = 0;
+	ssize_t n;
+
+	if (size <= 0) {
+		return copy_fd_rw(from_fd, to_fd, 0);
+	}
+	//ںڸƣͬһļϵͳϿֱӹݿ
+	while ((n = copy_file_range(from_fd, NULL, to_fd, NULL, COPY_CHUNK, 0)) != 0) {
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if (copied == 0 && copy_unsupported(errno))
+				break;
+			return -1;
+		}
+		copied += n;
+	}
+	//һʼͷ0ʱαļϵͳں˵sysfsС0֧֣ķʽ
+	if (n == 0 && copied > 0)
+		return copied;
+
+	if (fallocate(to_fd, 0, 0, size) == -1 && errno != EOPNOTSUPP && errno != ENOSYS) {
+		return -1;
+	}
+	posix_fadvise(from_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	while ((n = sendfile(to_fd, from_fd, NULL, COPY_CHUNK)) != 0) {
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if (copied == 0 && copy_unsupported(errno))
+				break;
+			return -1;
+		}
+		copied += n;
+	}
+	if (n != 0 || copied == 0) {
+		copied = copy_fd_rw(from_fd, to_fd, 0);
+	}
+	//ԴļڸƹбʱȥԤβ
+	if (copied >= 0 && copied < size && ftruncate(to_fd, copied) == -1) {
+		return -1;
+	}
+	return copied;
+}
+
+/**
+ * @brief Ѵ򿪵ļflagsCOPY_CLONEʱFICLONEݿ飬֧ʱٸơ
+ * 
+ * @return Ƶֽʧܷ-1
+ */
+static S64 copy_data(int from_fd, int to_fd, const struct stat *st, int flags, COPY_METHOD *method)
+{
+	*method = COPY_COPIED;
+	if ((flags & COPY_CLONE) && S_ISREG(st->st_mode)) {
+		if (ioctl(to_fd, FICLONE, from_fd) == 0) {
+			*method = COPY_CLONED;
+			return st->st_size;
+		}
+		if (!copy_unsupported(errno) && errno != EPERM) {
+			return -1;
+		}
+	}
+	return copy_fd(from_fd, to_fd, S_ISREG(st->st_mode) ? st->st_size : 0);
+}
+
+//ӲӲ֧֣ļϵͳ޵ȣʱЩ󣬿ɸΪ
+static int link_unsupported(int err)
+{
+	return err == EXDEV || err == EPERM || err == EMLINK || err == EOPNOTSUPP || err == ENOSYS;
+}
+
+/**
+ * @brief ӲӡĿѴʱӵͬĿ¼ʱļٸ滻
+ * ɾĿ꣬ʧʱĿ걣ԭ
+ * 
+ * @return ɹ0ʧܷ-1
+ */
+static int copy_link_at(int from_dirfd, const char *from_file, int to_dirfd, const char *to_file)
+{
+	static unsigned seq;
+	char tmp[64];
+	int err;
+
+	if (linkat(from_dirfd, from_file, to_dirfd, to_file, AT_SYMLINK_FOLLOW) == 0)
+		return 0;
+	if (errno != EEXIST)
+		return -1;
+	snprintf(tmp, sizeof(tmp), ".copy.%d.%u.tmp", (int)getpid(), __atomic_add_fetch(&seq, 1, __ATOMIC_RELAXED));
+	if (linkat(from_dirfd, from_file, to_dirfd, tmp, AT_SYMLINK_FOLLOW) == -1)
+		return -1;
+	if (renameat(to_dirfd, tmp, to_dirfd, to_file) == -1) {
+		err = errno;
+		unlinkat(to_dirfd, tmp, 0);
+		errno = err;
+		return -1;
+	}
+	//ʱļĿͬһinodeʱrenameʲôҲʱļ
+	unlinkat(to_dirfd, tmp, 0);
+	return 0;
+}
 
+/**
+ * @brief dirfdµļĿ¼ΪAT_FDCWDʱͬ·ơ
+ * 
+ * @return Ƶֽʧܷ-1
+ */
+static S64 copy_file_at(int from_dirfd, const char *from_file, int to_dirfd, const char *to_file, int flags, COPY_METHOD *method)
+{
+	S64 iRet = -1;
+	int from_fd, to_fd;
+	struct stat st, dt;
+
+	*method = COPY_COPIED;
 	if (!from_file || !to_file) {
 		errno = EBADF;
 		goto ERR;
 	}
-	if ((from_fd = open(from_file, O_RDONLY)) == -1) {
+	if ((from_fd = openat(from_dirfd, from_file, O_RDONLY | O_CLOEXEC)) == -1) {
 		goto ERR;
 	}
-	if ((to_fd = open(to_file, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR)) == -1) {
+	if (fstat(from_fd, &st) == -1) {
 		goto ERR_FROM;
 	}
-	while ((read_size = read(from_fd, buffer, BUFFER_SIZE))) {
-		if (read_size == -1 && errno != EINTR) {
-			goto ERR_TO;
-		} else if (read_size > 0) {
-            p = buffer;
-            while ((write_size = write(to_fd, p, read_size))) {
-				size += write_size;
-				if (write_size == -1 && errno != EINTR) {
-					goto ERR_TO;
-				} else if (write_size == read_size) {
-					break;
-				} else if (write_size < read_size) {
-				   p += write_size;
-				   read_size -= write_size;
-				} else if (write_size > read_size) {
-				   errno = EINVAL;
-				   goto ERR_TO;
-				}
-			}
-        }
-    }
-	iRet = size;
-ERR_TO:
+	if ((flags & COPY_LINK) && S_ISREG(st.st_mode)) {
+		//ĿԴļӲʱô
+		if (fstatat(to_dirfd, to_file, &dt, 0) == 0 && dt.st_ino == st.st_ino && dt.st_dev == st.st_dev) {
+			*method = COPY_LINKED;
+			iRet = st.st_size;
+			goto ERR_FROM;
+		}
+		if (copy_link_at(from_dirfd, from_file, to_dirfd, to_file) == 0) {
+			*method = COPY_LINKED;
+			iRet = st.st_size;
+			goto ERR_FROM;
+		}
+		if (!link_unsupported(errno)) {
+			goto ERR_FROM;
+		}
+	}
+	//ȲضϣĿԴļӲʱضϻᶪʧ
+	if ((to_fd = openat(to_dirfd, to_file, O_WRONLY | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR)) == -1) {
+		goto ERR_FROM;
+	}
+	if (fstat(to_fd, &dt) == 0 && dt.st_ino == st.st_ino && dt.st_dev == st.st_dev) {
+		*method = COPY_LINKED;
+		iRet = st.st_size;
+	} else if (ftruncate(to_fd, 0) == 0) {
+		iRet = copy_data(from_fd, to_fd, &st, flags, method);
+	}
 	close(to_fd);
 ERR_FROM:
 	close(from_fd);
@@ -56,77 +277,1591 @@ ERR:
 	return iRet;
 }
 
-int copy_dir(const char *from_path, const char *to_path)
+S64 copy_file(const char *from_file, const char *to_file)
 {
-	int iRet = -1, size = 0;
-	DIR *from_dir = NULL, *to_dir = NULL;
-	struct dirent *ptr = NULL;
-	char *from_sub_path = NULL, *to_sub_path = NULL;
+	return copy_filex(from_file, to_file, 0, NULL);
+}
 
-	if (!from_path || !to_path) {
-		errno = EBADF;
-		return iRet;
+/**
+ * @brief ļԿ¡ݿӲӡ
+ * 
+ * @param flags COPY_CLONEȳFICLONECOPY_LINKȳԽӲӣĿԴͬһinode
+ *        ֻʺֻݣʱơ
+ * @param method Ϊʱʵʲõķʽ
+ * 
+ * @return ļֽʧܷ-1
+ */
+S64 copy_filex(const char *from_file, const char *to_file, int flags, COPY_METHOD *method)
+{
+	COPY_METHOD m;
+
+	return copy_file_at(AT_FDCWD, from_file, AT_FDCWD, to_file, flags, method ? method : &m);
+}
+
+/*
+ * Ŀ¼ơ
+ * ÿѴ򿪵Ŀ¼һCOPY_DIRڵ㣬ԴĿĿ¼fdü
+ * ɨĿ¼̳߳һãĿ¼ÿĿһã
+ * һͷʱرfdĿ(COPY_ITEM)ֻ֣openatԸĿ¼fd򿪣
+ * ƴ·ÿ߳Լ˫˶УβȡԼĿӽȣ
+ * ͬʱ򿪵Ŀ¼٣ʱ̶߳еͷȡ
+ */
+typedef struct COPY_DIR {
+	int from_fd;
+	int to_fd;
+	int refs;
+}COPY_DIR;
+
+typedef struct {
+	COPY_DIR *parent;
+	int is_dir;
+	char name[];
+}COPY_ITEM;
+
+typedef struct {
+	pthread_mutex_t lock;
+	COPY_ITEM **items;
+	size_t cap;
+	size_t head;		/* ȡ */
+	size_t tail;		/* ̴߳ȡ */
+}COPY_DEQUE;
+
+/* ͬ嵥һԴļıʶ */
+typedef struct {
+	U64 dev;
+	U64 ino;
+	U64 size;
+	U64 sec;
+	U64 nsec;
+}COPY_KEY;
+
+typedef struct COPY_POOL COPY_POOL;
+typedef struct COPY_RING COPY_RING;
+
+typedef struct {
+	COPY_POOL *pool;
+	int index;
+	pthread_t tid;
+	COPY_DEQUE deque;
+	COPY_RING *ring;	/* COPY_URINGʱio_uringʱΪ */
+}COPY_WORKER;
+
+struct COPY_POOL {
+	COPY_TASK *task;
+	COPY_WORKER *workers;
+	int nworkers;
+	long pending;		/* ӵδĿ */
+	int sleepers;
+	unsigned gen;		/* Ŀȫʱ */
+	int stop;			/* ʱcopy_failãtask->cancelֻcopy_cancel */
+	int manifest_fd;	/* ͬ嵥δʹʱΪ-1 */
+	COPY_KEY *done;		/* 嵥ɵļ */
+	size_t ndone;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+};
+
+static void copy_dir_release(COPY_DIR *dir)
+{
+	if (dir && __atomic_sub_fetch(&dir->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		if (dir->from_fd != AT_FDCWD)
+			close(dir->from_fd);
+		if (dir->to_fd != AT_FDCWD)
+			close(dir->to_fd);
+		free(dir);
 	}
-	if ((from_sub_path = (char *)malloc(DIR_MAXPATH)) == NULL) {
+}
+
+//¼һֹͣ߳
+static void copy_fail(COPY_POOL *pool)
+{
+	int expected = 0;
+
+	__atomic_add_fetch(&pool->task->stat.errors, 1, __ATOMIC_RELAXED);
+	__atomic_compare_exchange_n(&pool->task->err, &expected, errno ? errno : EIO, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	__atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+}
+
+//ȡٿʼµĿ
+static int copy_stopped(COPY_POOL *pool)
+{
+	return __atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE) || __atomic_load_n(&pool->task->cancel, __ATOMIC_ACQUIRE);
+}
+
+static int copy_push(COPY_WORKER *w, COPY_DIR *parent, const char *name, int is_dir)
+{
+	COPY_POOL *pool = w->pool;
+	COPY_DEQUE *d = &w->deque;
+	COPY_ITEM *item, **items;
+	size_t len = strlen(name) + 1, i, n;
+
+	if ((item = (COPY_ITEM *)malloc(sizeof(COPY_ITEM) + len)) == NULL) {
 		errno = ENOMEM;
-		return iRet;
+		return -1;
 	}
-	if ((to_sub_path = (char *)malloc(DIR_MAXPATH)) == NULL) {
-		free(from_sub_path);
-		errno = ENOMEM;
-		return iRet;
+	item->parent = parent;
+	item->is_dir = is_dir;
+	memcpy(item->name, name, len);
+	if (parent)
+		__atomic_add_fetch(&parent->refs, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+
+	pthread_mutex_lock(&d->lock);
+	if (d->tail - d->head == d->cap) {
+		n = d->cap ? d->cap * 2 : 64;
+		if ((items = (COPY_ITEM **)malloc(n * sizeof(COPY_ITEM *))) == NULL) {
+			pthread_mutex_unlock(&d->lock);
+			__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+			copy_dir_release(parent);
+			free(item);
+			errno = ENOMEM;
+			return -1;
+		}
+		for (i = d->head; i < d->tail; i++)
+			items[i - d->head] = d->items[i % d->cap];
+		free(d->items);
+		d->items = items;
+		d->tail -= d->head;
+		d->head = 0;
+		d->cap = n;
+	}
+	d->items[d->tail++ % d->cap] = item;
+	pthread_mutex_unlock(&d->lock);
+
+	//߳ڵȴʱһ
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&pool->lock);
+		pool->gen++;
+		pthread_cond_signal(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+	}
+	return 0;
+}
+
+static COPY_ITEM *copy_take(COPY_DEQUE *d, int steal)
+{
+	COPY_ITEM *item = NULL;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->head != d->tail) {
+		if (steal)
+			item = d->items[d->head++ % d->cap];
+		else
+			item = d->items[--d->tail % d->cap];
 	}
-	if ((from_dir = opendir(from_path)) == NULL) {
+	pthread_mutex_unlock(&d->lock);
+	return item;
+}
+
+static COPY_ITEM *copy_next(COPY_WORKER *w)
+{
+	COPY_POOL *pool = w->pool;
+	COPY_ITEM *item;
+	int i;
+
+	if ((item = copy_take(&w->deque, 0)))
+		return item;
+	for (i = 1; i < pool->nworkers; i++) {
+		if ((item = copy_take(&pool->workers[(w->index + i) % pool->nworkers].deque, 1)))
+			return item;
+	}
+	return NULL;
+}
+
+//ԴĿ¼ѴֱӴ򿪣ĿĿ¼
+static COPY_DIR *copy_open_dir(COPY_POOL *pool, int from_dirfd, const char *from_name, int to_dirfd, const char *to_name)
+{
+	COPY_DIR *dir;
+
+	if ((dir = (COPY_DIR *)malloc(sizeof(COPY_DIR))) == NULL) {
+		errno = ENOMEM;
 		goto ERR;
 	}
-	if ((to_dir = opendir(to_path)) == NULL) {
-		if (mkdir(to_path, 0770) == -1) {
-			goto ERR_FROM;
+	dir->refs = 1;
+	dir->to_fd = -1;
+	if ((dir->from_fd = openat(from_dirfd, from_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		goto ERR_FREE;
+	}
+	if (mkdirat(to_dirfd, to_name, 0770) == 0) {
+		__atomic_add_fetch(&pool->task->stat.dirs, 1, __ATOMIC_RELAXED);
+	} else if (errno != EEXIST) {
+		goto ERR_FROM;
+	}
+	if ((dir->to_fd = openat(to_dirfd, to_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1) {
+		goto ERR_FROM;
+	}
+	return dir;
+ERR_FROM:
+	close(dir->from_fd);
+ERR_FREE:
+	free(dir);
+ERR:
+	copy_fail(pool);
+	return NULL;
+}
+
+//Ŀ¼еĿ¼ͨļӣȻͷɨе
+static void copy_list(COPY_WORKER *w, COPY_DIR *dir)
+{
+	DIR *dp;
+	struct dirent *ptr;
+	struct stat st;
+	int fd, is_dir;
+
+	//fdopendirӹfddupһݣfrom_fdĿopenatʹ
+	if ((fd = dup(dir->from_fd)) == -1 || (dp = fdopendir(fd)) == NULL) {
+		if (fd != -1)
+			close(fd);
+		copy_fail(w->pool);
+		copy_dir_release(dir);
+		return;
+	}
+	while (!copy_stopped(w->pool) && (ptr = readdir(dp))) {
+		if (strcmp(ptr->d_name, ".") == 0 || strcmp(ptr->d_name, "..") == 0) {
+			continue;
 		}
-		if ((to_dir = opendir(to_path)) == NULL) {
-			goto ERR_FROM;
+		if (ptr->d_type == DT_UNKNOWN) {
+			if (fstatat(dir->from_fd, ptr->d_name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+				copy_fail(w->pool);
+				break;
+			}
+			is_dir = S_ISDIR(st.st_mode) ? 1 : S_ISREG(st.st_mode) ? 0 : -1;
+		} else {
+			is_dir = ptr->d_type == DT_DIR ? 1 : ptr->d_type == DT_REG ? 0 : -1;
+		}
+		if (is_dir < 0) {
+			continue;
+		}
+		if (copy_push(w, dir, ptr->d_name, is_dir) == -1) {
+			copy_fail(w->pool);
+			break;
 		}
 	}
-	while ((ptr = readdir(from_dir))) {
-		if (ptr->d_type == DT_DIR) {
-			if (strcmp(ptr->d_name, ".") == 0 || strcmp(ptr->d_name, "..") == 0) {
-				continue;
-			}
-			if (strlen(ptr->d_name) > DIR_MAXPATH) {
+	closedir(dp);
+	copy_dir_release(dir);
+}
+
+/*
+ * ͬģʽ
+ * ļдĿĿ¼µʱļԴͬķʺ޸ʱrenameat滻
+ * жʱĿĿ¼ֻʱļдһĿļ
+ * 嵥ÿм¼һɵԴļ(豸inodeС޸ʱ)ֻ׷ӣ
+ * жϺʱ嵥еļٱȽݣȫɺɾ嵥
+ */
+static void copy_key(COPY_KEY *key, const struct stat *st)
+{
+	key->dev = st->st_dev;
+	key->ino = st->st_ino;
+	key->size = st->st_size;
+	key->sec = st->st_mtim.tv_sec;
+	key->nsec = st->st_mtim.tv_nsec;
+}
+
+static int copy_key_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, sizeof(COPY_KEY));
+}
+
+//ȡ嵥򣬲Удʱжϣ
+static int copy_manifest_load(COPY_POOL *pool, const char *path)
+{
+	FILE *fp;
+	char line[128];
+	COPY_KEY key, *keys;
+	size_t cap = 0;
+	int n;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return errno == ENOENT ? 0 : -1;
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "%llx %llx %llx %llx %llx%n", (unsigned long long *)&key.dev, (unsigned long long *)&key.ino,
+				(unsigned long long *)&key.size, (unsigned long long *)&key.sec, (unsigned long long *)&key.nsec, &n) != 5
+				|| line[n] != '\n')
+			continue;
+		if (pool->ndone == cap) {
+			cap = cap ? cap * 2 : 256;
+			if ((keys = (COPY_KEY *)realloc(pool->done, cap * sizeof(COPY_KEY))) == NULL) {
+				fclose(fp);
 				errno = ENOMEM;
-				goto ERR_TO;
+				return -1;
 			}
-			memset(from_sub_path, 0, DIR_MAXPATH);
-			sprintf(from_sub_path, "%s/%s", from_path, ptr->d_name);
-			to_sub_path = (char *)malloc(DIR_MAXPATH);
-			memset(to_sub_path, 0, DIR_MAXPATH);
-			sprintf(to_sub_path, "%s/%s", to_path, ptr->d_name);
-			if ((iRet = copy_dir(from_sub_path, to_sub_path)) == -1) {
-				goto ERR_TO;
+			pool->done = keys;
+		}
+		pool->done[pool->ndone++] = key;
+	}
+	fclose(fp);
+	if (pool->ndone)
+		qsort(pool->done, pool->ndone, sizeof(COPY_KEY), copy_key_cmp);
+	return 0;
+}
+
+static int copy_manifest_has(COPY_POOL *pool, const COPY_KEY *key)
+{
+	return pool->ndone && bsearch(key, pool->done, pool->ndone, sizeof(COPY_KEY), copy_key_cmp) != NULL;
+}
+
+//һһwriteO_APPEND̵֤߳ļ¼
+static void copy_manifest_add(COPY_POOL *pool, const COPY_KEY *key)
+{
+	char line[128];
+	int len;
+
+	if (pool->manifest_fd == -1)
+		return;
+	len = snprintf(line, sizeof(line), "%llx %llx %llx %llx %llx\n", (unsigned long long)key->dev, (unsigned long long)key->ino,
+			(unsigned long long)key->size, (unsigned long long)key->sec, (unsigned long long)key->nsec);
+	while (write(pool->manifest_fd, line, len) == -1 && errno == EINTR)
+		;
+}
+
+/**
+ * @brief Ƚļǰsizeֽڡ
+ * 
+ * @return ͬ1ͬ0ʧܷ-1
+ */
+static int copy_same(int fd1, int fd2, off_t size)
+{
+	int iRet = -1;
+	byte *buffer = NULL;
+	ssize_t n1, n2;
+	off_t offset = 0;
+
+	if (posix_memalign((void **)&buffer, BUFFER_ALIGN, BUFFER_SIZE * 2) != 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+	while (offset < size) {
+		if ((n1 = pread(fd1, buffer, BUFFER_SIZE, offset)) == -1 || (n2 = pread(fd2, buffer + BUFFER_SIZE, BUFFER_SIZE, offset)) == -1) {
+			if (errno == EINTR)
+				continue;
+			goto ERR;
+		}
+		if (n1 != n2 || memcmp(buffer, buffer + BUFFER_SIZE, n1) != 0) {
+			iRet = 0;
+			goto ERR;
+		}
+		if (n1 == 0)
+			break;
+		offset += n1;
+	}
+	iRet = 1;
+ERR:
+	free(buffer);
+	return iRet;
+}
+
+/**
+ * @brief ͬһļδ仯ʱʱļ滻Ŀļ
+ * 
+ * @return Ƶֽʧܷ-1ʱ0*skip1
+ */
+static S64 copy_sync_file(COPY_WORKER *w, COPY_DIR *parent, const char *name, int *skip, COPY_METHOD *method)
+{
+	COPY_POOL *pool = w->pool;
+	COPY_TASK *task = pool->task;
+	S64 iRet = -1;
+	int from_fd, to_fd, same;
+	struct stat st, dt;
+	struct timespec times[2];
+	char tmp[64];
+	COPY_KEY key;
+
+	if ((from_fd = openat(parent->from_fd, name, O_RDONLY | O_CLOEXEC)) == -1) {
+		return -1;
+	}
+	if (fstat(from_fd, &st) == -1) {
+		goto ERR;
+	}
+	copy_key(&key, &st);
+	if (S_ISREG(st.st_mode) && fstatat(parent->to_fd, name, &dt, AT_SYMLINK_NOFOLLOW) == 0 && S_ISREG(dt.st_mode)
+			&& dt.st_size == st.st_size && dt.st_mtim.tv_sec == st.st_mtim.tv_sec && dt.st_mtim.tv_nsec == st.st_mtim.tv_nsec) {
+		same = 1;
+		//ӲӵԴļĿ겻ñȽ
+		if ((task->flags & COPY_COMPARE) && (dt.st_ino != st.st_ino || dt.st_dev != st.st_dev) && !copy_manifest_has(pool, &key)) {
+			if ((to_fd = openat(parent->to_fd, name, O_RDONLY | O_CLOEXEC)) == -1) {
+				goto ERR;
 			}
-			size += iRet;
-		} else if (ptr->d_type == DT_REG) {
-			from_sub_path = (char *)malloc(DIR_MAXPATH);
-			memset(from_sub_path, 0, DIR_MAXPATH);
-			sprintf(from_sub_path, "%s/%s", from_path, ptr->d_name);
-			memset(to_sub_path, 0, DIR_MAXPATH);
-			sprintf(to_sub_path, "%s/%s", to_path, ptr->d_name);
-			if ((iRet = copy_file(from_sub_path, to_sub_path)) == -1) {
-				goto ERR_TO;
+			same = copy_same(from_fd, to_fd, st.st_size);
+			close(to_fd);
+			if (same == -1) {
+				goto ERR;
 			}
-			size += iRet;
+		}
+		if (same) {
+			*skip = 1;
+			copy_manifest_add(pool, &key);
+			iRet = 0;
+			goto ERR;
+		}
+	}
+
+	//Դinode̺߳ţͬʱдʱļӲӵԴļinodeͬ
+	snprintf(tmp, sizeof(tmp), ".copy.%llx.%d.tmp", (unsigned long long)st.st_ino, w->index);
+	if ((task->flags & COPY_LINK) && S_ISREG(st.st_mode)) {
+		unlinkat(parent->to_fd, tmp, 0);
+		if (linkat(parent->from_fd, name, parent->to_fd, tmp, AT_SYMLINK_FOLLOW) == 0) {
+			*method = COPY_LINKED;
+			iRet = st.st_size;
+			goto RENAME;
+		}
+		if (!link_unsupported(errno)) {
+			goto ERR;
+		}
+	}
+	if ((to_fd = openat(parent->to_fd, tmp, O_WRONLY | O_TRUNC | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR)) == -1) {
+		goto ERR;
+	}
+	times[0] = st.st_atim;
+	times[1] = st.st_mtim;
+	if ((iRet = copy_data(from_fd, to_fd, &st, task->flags, method)) == -1 || futimens(to_fd, times) == -1) {
+		iRet = -1;
+		close(to_fd);
+		goto ERR_TMP;
+	}
+	close(to_fd);
+RENAME:
+	if (renameat(parent->to_fd, tmp, parent->to_fd, name) == -1) {
+		iRet = -1;
+		goto ERR_TMP;
+	}
+	copy_manifest_add(pool, &key);
+	goto ERR;
+ERR_TMP:
+	same = errno;
+	unlinkat(parent->to_fd, tmp, 0);
+	errno = same;
+ERR:
+	close(from_fd);
+	return iRet;
+}
+
+static void copy_process(COPY_WORKER *w, COPY_ITEM *item)
+{
+	COPY_TASK *task = w->pool->task;
+	COPY_DIR *dir;
+	S64 size;
+	int skip = 0;
+	COPY_METHOD method = COPY_COPIED;
+
+	if (!copy_stopped(w->pool)) {
+		if (item->is_dir) {
+			if ((dir = copy_open_dir(w->pool, item->parent->from_fd, item->name, item->parent->to_fd, item->name)))
+				copy_list(w, dir);
+		} else if ((size = (task->flags & COPY_SYNC) ? copy_sync_file(w, item->parent, item->name, &skip, &method)
+				: copy_file_at(item->parent->from_fd, item->name, item->parent->to_fd, item->name, task->flags, &method)) == -1) {
+			copy_fail(w->pool);
+		} else if (skip) {
+			__atomic_add_fetch(&task->stat.skipped, 1, __ATOMIC_RELAXED);
 		} else {
+			__atomic_add_fetch(&task->stat.bytes, size, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&task->stat.files, 1, __ATOMIC_RELAXED);
+			if (method == COPY_CLONED)
+				__atomic_add_fetch(&task->stat.cloned, 1, __ATOMIC_RELAXED);
+			else if (method == COPY_LINKED)
+				__atomic_add_fetch(&task->stat.linked, 1, __ATOMIC_RELAXED);
+			if (method != COPY_COPIED)
+				__atomic_add_fetch(&task->stat.shared, size, __ATOMIC_RELAXED);
+		}
+	}
+	copy_dir_release(item->parent);
+	free(item);
+}
+
+//ȴĿȫĿʱNULL
+static COPY_ITEM *copy_wait(COPY_WORKER *w)
+{
+	COPY_POOL *pool = w->pool;
+	COPY_ITEM *item;
+	unsigned gen;
+
+	for (;;) {
+		//ȵǼΪȴټһΣcopy_push
+		pthread_mutex_lock(&pool->lock);
+		gen = pool->gen;
+		__atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&pool->lock);
+		item = copy_next(w);
+		pthread_mutex_lock(&pool->lock);
+		if (item == NULL) {
+			while (gen == pool->gen && __atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0)
+				pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		__atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&pool->lock);
+		if (item)
+			return item;
+		if (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) == 0)
+			return NULL;
+		if ((item = copy_next(w)))
+			return item;
+	}
+}
+
+//һĿ꣬һʱ߳˳
+static void copy_done(COPY_POOL *pool)
+{
+	if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST) == 0) {
+		pthread_mutex_lock(&pool->lock);
+		pool->gen++;
+		pthread_cond_broadcast(&pool->wake);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/*
+ * io_uring(COPY_URING)
+ * ÿ߳һliburingֱʹϵͳádepthҵۣÿ۶Ӧ
+ * һעỺ棬ͬʱdepthСļÿļύдͬļͬʱڷɡ
+ * ļڿʼܻḴ꣬ȡֹֻͣʼļ򿪡رļͬģ
+ * ļͬģʽͿ¡ģʽԭcopy_process
+ * ں˲ֻ֧򱻽ʱ̰߳ԭķʽơ
+ */
+#ifdef __NR_io_uring_setup
+
+typedef struct {
+	COPY_ITEM *item;
+	int from_fd;
+	int to_fd;
+	off_t offset;		/* дֽ */
+	unsigned len;		/* жֽ */
+	unsigned done;		/* дֽ */
+}COPY_JOB;
+
+struct COPY_RING {
+	int fd;
+	int fixed;			/* Ƿע */
+	int dead;			/* io_uring_enterʧܣʹ */
+	unsigned entries;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr, *cq_ptr;
+	size_t sq_len, cq_len;
+	unsigned queued;	/* дδύ */
+	unsigned active;	/* ڸƵļ */
+	byte *bufs;
+	COPY_JOB *jobs;
+	unsigned *free;		/* вջ */
+	unsigned nfree;
+};
+
+static void copy_ring_free(COPY_RING *ring)
+{
+	unsigned i;
+
+	if (ring == NULL)
+		return;
+	//ȹرջںȡδɵǳеļã֮رfdӰļ
+	if (ring->fd >= 0)
+		close(ring->fd);
+	ring->fd = -1;
+	if (ring->jobs) {
+		for (i = 0; i < ring->entries; i++) {
+			if (ring->jobs[i].from_fd >= 0)
+				close(ring->jobs[i].from_fd);
+			if (ring->jobs[i].to_fd >= 0)
+				close(ring->jobs[i].to_fd);
+		}
+	}
+	//ʧЧĻϿܻ첽ִУ治ͷţںдѱ·ڴ
+	if (ring->dead)
+		ring->bufs = NULL;
+	if (ring->sqes && ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, ring->entries * sizeof(struct io_uring_sqe));
+	if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_len);
+	if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED)
+		munmap(ring->sq_ptr, ring->sq_len);
+	free(ring->bufs);
+	free(ring->jobs);
+	free(ring->free);
+	free(ring);
+}
+
+static COPY_RING *copy_ring_new(unsigned depth)
+{
+	COPY_RING *ring;
+	struct io_uring_params p;
+	struct iovec *iov;
+	unsigned i;
+	int err;
+
+	if ((ring = (COPY_RING *)calloc(1, sizeof(COPY_RING))) == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	memset(&p, 0, sizeof(p));
+	if ((ring->fd = syscall(__NR_io_uring_setup, depth, &p)) < 0) {
+		goto ERR;
+	}
+	ring->entries = p.sq_entries;
+	ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_len > ring->sq_len)
+			ring->sq_len = ring->cq_len;
+		ring->cq_len = ring->sq_len;
+	}
+	ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED) {
+		goto ERR;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else if ((ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING)) == MAP_FAILED) {
+		goto ERR;
+	}
+	ring->sqes = (struct io_uring_sqe *)mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		goto ERR;
+	}
+	ring->sq_head = (unsigned *)((byte *)ring->sq_ptr + p.sq_off.head);
+	ring->sq_tail = (unsigned *)((byte *)ring->sq_ptr + p.sq_off.tail);
+	ring->sq_mask = (unsigned *)((byte *)ring->sq_ptr + p.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)((byte *)ring->sq_ptr + p.sq_off.array);
+	ring->cq_head = (unsigned *)((byte *)ring->cq_ptr + p.cq_off.head);
+	ring->cq_tail = (unsigned *)((byte *)ring->cq_ptr + p.cq_off.tail);
+	ring->cq_mask = (unsigned *)((byte *)ring->cq_ptr + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)((byte *)ring->cq_ptr + p.cq_off.cqes);
+
+	//ÿļͬʱֻһҵύг
+	if ((ring->jobs = (COPY_JOB *)calloc(ring->entries, sizeof(COPY_JOB)))) {
+		for (i = 0; i < ring->entries; i++)
+			ring->jobs[i].from_fd = ring->jobs[i].to_fd = -1;
+	}
+	ring->free = (unsigned *)malloc(ring->entries * sizeof(unsigned));
+	if (!ring->jobs || !ring->free || posix_memalign((void **)&ring->bufs, BUFFER_ALIGN, (size_t)ring->entries * COPY_RING_BUF) != 0) {
+		ring->bufs = NULL;
+		errno = ENOMEM;
+		goto ERR;
+	}
+	for (i = 0; i < ring->entries; i++)
+		ring->free[ring->nfree++] = ring->entries - 1 - i;
+	//עʧܣڴƣʱͨд
+	if ((iov = (struct iovec *)malloc(ring->entries * sizeof(struct iovec)))) {
+		for (i = 0; i < ring->entries; i++) {
+			iov[i].iov_base = ring->bufs + (size_t)i * COPY_RING_BUF;
+			iov[i].iov_len = COPY_RING_BUF;
+		}
+		ring->fixed = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, iov, ring->entries) == 0;
+		free(iov);
+	}
+	return ring;
+ERR:
+	err = errno;
+	copy_ring_free(ring);
+	errno = err;
+	return NULL;
+}
+
+static void copy_ring_prep(COPY_RING *ring, unsigned slot, int write)
+{
+	COPY_JOB *job = &ring->jobs[slot];
+	unsigned tail = *ring->sq_tail, index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	if (write) {
+		sqe->opcode = ring->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+		sqe->fd = job->to_fd;
+		sqe->addr = (unsigned long)(ring->bufs + (size_t)slot * COPY_RING_BUF + job->done);
+		sqe->len = job->len - job->done;
+		sqe->off = job->offset;
+	} else {
+		sqe->opcode = ring->fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+		sqe->fd = job->from_fd;
+		sqe->addr = (unsigned long)(ring->bufs + (size_t)slot * COPY_RING_BUF);
+		sqe->len = COPY_RING_BUF;
+		sqe->off = job->offset;
+	}
+	if (ring->fixed)
+		sqe->buf_index = slot;
+	sqe->user_data = slot;
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->queued++;
+}
+
+static void copy_ring_finish(COPY_WORKER *w, unsigned slot, int err)
+{
+	COPY_RING *ring = w->ring;
+	COPY_JOB *job = &ring->jobs[slot];
+	COPY_TASK *task = w->pool->task;
+
+	close(job->from_fd);
+	close(job->to_fd);
+	job->from_fd = job->to_fd = -1;
+	if (err) {
+		errno = err;
+		copy_fail(w->pool);
+	} else {
+		__atomic_add_fetch(&task->stat.bytes, job->offset, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&task->stat.files, 1, __ATOMIC_RELAXED);
+	}
+	copy_dir_release(job->item->parent);
+	free(job->item);
+	job->item = NULL;
+	ring->free[ring->nfree++] = slot;
+	ring->active--;
+	copy_done(w->pool);
+}
+
+/**
+ * @brief Сļ򿪺в۲ύһζĿͬ
+ */
+static void copy_ring_item(COPY_WORKER *w, COPY_ITEM *item)
+{
+	COPY_RING *ring = w->ring;
+	COPY_TASK *task = w->pool->task;
+	COPY_DIR *parent = item->parent;
+	COPY_JOB *job;
+	struct stat st, dt;
+	int from_fd, to_fd;
+	unsigned slot;
+
+	if (item->is_dir || (task->flags & (COPY_SYNC | COPY_CLONE | COPY_LINK)) || copy_stopped(w->pool)) {
+		goto SYNC;
+	}
+	if ((from_fd = openat(parent->from_fd, item->name, O_RDONLY | O_CLOEXEC)) == -1) {
+		goto FAIL;
+	}
+	if (fstat(from_fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size > COPY_RING_MAX) {
+		close(from_fd);
+		goto SYNC;
+	}
+	if ((to_fd = openat(parent->to_fd, item->name, O_WRONLY | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR)) == -1) {
+		close(from_fd);
+		goto FAIL;
+	}
+	//ĿԴļʱcopy_process
+	if (fstat(to_fd, &dt) == -1 || (dt.st_ino == st.st_ino && dt.st_dev == st.st_dev) || ftruncate(to_fd, 0) == -1) {
+		close(to_fd);
+		close(from_fd);
+		goto SYNC;
+	}
+	slot = ring->free[--ring->nfree];
+	job = &ring->jobs[slot];
+	job->item = item;
+	job->from_fd = from_fd;
+	job->to_fd = to_fd;
+	job->offset = 0;
+	job->len = job->done = 0;
+	ring->active++;
+	copy_ring_prep(ring, slot, 0);
+	return;
+FAIL:
+	copy_fail(w->pool);
+	copy_dir_release(parent);
+	free(item);
+	copy_done(w->pool);
+	return;
+SYNC:
+	copy_process(w, item);
+	copy_done(w->pool);
+}
+
+/**
+ * @brief ύдٵȵһɣȻƽļĶд
+ */
+static void copy_ring_reap(COPY_WORKER *w)
+{
+	COPY_RING *ring = w->ring;
+	COPY_JOB *job;
+	struct io_uring_cqe *cqe;
+	unsigned head, tail, slot;
+	int res, ret;
+
+	ret = syscall(__NR_io_uring_enter, ring->fd, ring->queued, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+	if (ret >= 0) {
+		ring->queued -= (unsigned)ret < ring->queued ? (unsigned)ret : ring->queued;
+	} else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+		//ύִܻУҵΪʧܣۡfdͻ涼ٸã
+		//copy_ring_freeڹرջ֮ͷţ֮Ŀͨʽ
+		res = errno;
+		ring->dead = 1;
+		for (slot = 0; slot < ring->entries; slot++) {
+			if ((job = &ring->jobs[slot])->item == NULL)
+				continue;
+			errno = res;
+			copy_fail(w->pool);
+			copy_dir_release(job->item->parent);
+			free(job->item);
+			job->item = NULL;
+			copy_done(w->pool);
+		}
+		ring->active = 0;
+		ring->nfree = 0;
+		return;
+	}
+
+	head = *ring->cq_head;
+	tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != tail; head++) {
+		cqe = &ring->cqes[head & *ring->cq_mask];
+		slot = (unsigned)cqe->user_data;
+		res = cqe->res;
+		job = &ring->jobs[slot];
+		if (res == -EINTR || res == -EAGAIN) {
+			copy_ring_prep(ring, slot, job->len != 0);
 			continue;
 		}
+		if (res < 0) {
+			copy_ring_finish(w, slot, -res);
+		} else if (job->len == 0) {
+			//ɣ0ʾļ
+			if (res == 0) {
+				copy_ring_finish(w, slot, 0);
+			} else {
+				job->len = res;
+				job->done = 0;
+				copy_ring_prep(ring, slot, 1);
+			}
+		} else {
+			job->done += res;
+			job->offset += res;
+			if (res == 0) {
+				copy_ring_finish(w, slot, EIO);
+			} else if (job->done < job->len) {
+				copy_ring_prep(ring, slot, 1);
+			} else {
+				job->len = job->done = 0;
+				copy_ring_prep(ring, slot, 0);
+			}
+		}
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static void copy_ring_worker(COPY_WORKER *w)
+{
+	COPY_RING *ring = w->ring;
+	COPY_ITEM *item;
+
+	while (!ring->dead) {
+		while (ring->nfree && (item = copy_next(w)))
+			copy_ring_item(w, item);
+		if (ring->active) {
+			copy_ring_reap(w);
+			continue;
+		}
+		if ((item = copy_wait(w)) == NULL)
+			break;
+		copy_ring_item(w, item);
+	}
+}
+
+#else
+
+struct COPY_RING {
+	int fd;
+};
+
+static void copy_ring_free(COPY_RING *ring)
+{
+	free(ring);
+}
+
+static COPY_RING *copy_ring_new(unsigned depth)
+{
+	(void)depth;
+	errno = ENOSYS;
+	return NULL;
+}
+
+static void copy_ring_worker(COPY_WORKER *w)
+{
+	(void)w;
+}
+
+#endif
+
+static void *copy_worker(void *arg)
+{
+	COPY_WORKER *w = (COPY_WORKER *)arg;
+	COPY_ITEM *item;
+
+	//ʧЧʱcopy_ring_workerǰأʣµĿͨʽ
+	if (w->ring)
+		copy_ring_worker(w);
+	for (;;) {
+		if ((item = copy_next(w)) == NULL && (item = copy_wait(w)) == NULL)
+			break;
+		copy_process(w, item);
+		copy_done(w->pool);
+	}
+	return NULL;
+}
+
+/**
+ * @brief ö̸߳Ŀ¼ֻĿ¼ͨļ
+ * 
+ * @param from_path ԴĿ¼
+ * @param to_path ĿĿ¼ʱ
+ * @param task ߳ȡ־ͳƣΪաִڼ߳̿Զȡtask->stat
+ *        copy_cancelֹͣcopy_dirxcancelеcopy_cancelᶪʧ
+ *        ظʹtaskʱɵڵǰ0flagsCOPY_SYNCʱֻƱ仯ļ
+ *        ʱָmanifestжϺͬһ嵥ܻļݱȽϣ
+ *        ȫɺ嵥ɾ
+ * 
+ * @return Ƶֽʧܻȡ-1errnoΪһȡʱΪECANCELED
+ */
+S64 copy_dirx(const char *from_path, const char *to_path, COPY_TASK *task)
+{
+	S64 iRet = -1;
+	COPY_TASK local;
+	COPY_POOL pool;
+	COPY_DIR *dir;
+	int i, n, depth, started = 0;
+
+	if (!from_path || !to_path) {
+		errno = EBADF;
+		return -1;
+	}
+	if (!task) {
+		memset(&local, 0, sizeof(local));
+		task = &local;
+	}
+	memset(&task->stat, 0, sizeof(task->stat));
+	task->err = 0;
+	if ((n = task->threads) <= 0) {
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+		n = n < 1 ? 1 : n > COPY_THREADS_MAX ? COPY_THREADS_MAX : n;
+	}
+	memset(&pool, 0, sizeof(pool));
+	pool.task = task;
+	pool.nworkers = n;
+	pool.manifest_fd = -1;
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.wake, NULL);
+	if ((pool.workers = (COPY_WORKER *)calloc(n, sizeof(COPY_WORKER))) == NULL) {
+		errno = ENOMEM;
+		goto ERR;
+	}
+	for (i = 0; i < n; i++) {
+		pool.workers[i].pool = &pool;
+		pool.workers[i].index = i;
+		pthread_mutex_init(&pool.workers[i].deque.lock, NULL);
+	}
+	if (task->flags & COPY_URING) {
+		depth = task->depth > 0 ? task->depth : COPY_RING_DEPTH;
+		if (depth > COPY_RING_DEPTH_MAX)
+			depth = COPY_RING_DEPTH_MAX;
+		for (i = 0; i < n; i++) {
+			if ((pool.workers[i].ring = copy_ring_new(depth)) == NULL)
+				break;
+		}
+	}
+
+	if ((task->flags & COPY_SYNC) && task->manifest) {
+		if (copy_manifest_load(&pool, task->manifest) == -1) {
+			goto ERR;
+		}
+		if ((pool.manifest_fd = open(task->manifest, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR)) == -1) {
+			goto ERR;
+		}
+	}
+
+	//Ŀ¼߳ǰгĿһ̵߳ĶУ̴߳ȡ
+	if ((dir = copy_open_dir(&pool, AT_FDCWD, from_path, AT_FDCWD, to_path)) == NULL) {
+		goto ERR;
+	}
+	copy_list(&pool.workers[0], dir);
+	for (i = 0; i < n; i++) {
+		if (pthread_create(&pool.workers[i].tid, NULL, copy_worker, &pool.workers[i]) != 0)
+			break;
+		started++;
+	}
+	if (started == 0) {
+		copy_worker(&pool.workers[0]);
+	}
+	for (i = 0; i < started; i++) {
+		pthread_join(pool.workers[i].tid, NULL);
+	}
+	if (task->err) {
+		errno = task->err;
+	} else if (__atomic_load_n(&task->cancel, __ATOMIC_ACQUIRE)) {
+		errno = ECANCELED;
+	} else {
+		iRet = task->stat.bytes;
+		if (pool.manifest_fd != -1)
+			unlink(task->manifest);
 	}
-	iRet = size;
-ERR_TO:
-	closedir(to_dir);
-ERR_FROM:
-	closedir(from_dir);
 ERR:
-	free(to_sub_path);
-	free(from_sub_path);
+	if (pool.manifest_fd != -1)
+		close(pool.manifest_fd);
+	free(pool.done);
+	if (pool.workers) {
+		for (i = 0; i < n; i++) {
+			pthread_mutex_destroy(&pool.workers[i].deque.lock);
+			free(pool.workers[i].deque.items);
+			copy_ring_free(pool.workers[i].ring);
+		}
+		free(pool.workers);
+	}
+	pthread_cond_destroy(&pool.wake);
+	pthread_mutex_destroy(&pool.lock);
 	return iRet;
 }
 
+/**
+ * @brief ִֹͣеcopy_dirx̵߳á
+ */
+void copy_cancel(COPY_TASK *task)
+{
+	__atomic_store_n(&task->cancel, 1, __ATOMIC_RELEASE);
+}
+
+S64 copy_dir(const char *from_path, const char *to_path)
+{
+	return copy_dirx(from_path, to_path, NULL);
+}
+
+/*
+ * ļӳͼ
+ * ļʱֱӶҳ棬ٷڴ͸ơӳֻ(MAP_SHARED)
+ * VIEW_COWʱΪ˽пдӳ䣬޸Ĳдļ
+ */
+//ļӳ䣬ָĿͼڵͳһdata/len
+static const byte view_empty[1];
+
+//ҳӳ䣺ȱһҳĵַռ䣬ڶ봦ӳͷ
+static void *view_mmap_huge(size_t len, int prot, int flags, int fd, off_t offset)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	byte *base, *addr;
+	size_t head, tail, reserve;
+
+	//˶ҳ룬munmapEINVALĵַռ䲻ͷ
+	len = (len + page - 1) & ~(size_t)(page - 1);
+	reserve = len + VIEW_HUGE_SIZE;
+	base = (byte *)mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED)
+		return MAP_FAILED;
+	addr = (byte *)(((uintptr_t)base + VIEW_HUGE_SIZE - 1) & ~(uintptr_t)(VIEW_HUGE_SIZE - 1));
+	head = addr - base;
+	tail = reserve - head - len;
+	if (mmap(addr, len, prot, flags | MAP_FIXED, fd, offset) == MAP_FAILED
+			|| (head && munmap(base, head) == -1)
+			|| (tail && munmap(addr + len, tail) == -1)) {
+		munmap(base, reserve);
+		return MAP_FAILED;
+	}
+	return addr;
+}
+
+/**
+ * @brief ӳѴļһΣoffsetذҳ롣غfdԹرա
+ * 
+ * @param view صͼdataָļoffsetlenΪӳ䳤ȡ
+ * @param fd ļVIEW_COWʱҲֻҪȨޡ
+ * @param offset ʼλá
+ * @param len ȣ0Ϊļĩβ
+ * @param flags VIEW_*ϡ
+ * 
+ * @return ɹ0ʧܷ-1errnooffsetļĩβʱΪEINVAL
+ */
+int file_view_map(FILE_VIEW *view, int fd, off_t offset, size_t len, int flags)
+{
+	struct stat st;
+	long page = sysconf(_SC_PAGESIZE);
+	off_t start;
+	size_t delta, map_len;
+	int prot, mflags, advice;
+	void *map;
+
+	if (!view || offset < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(view, 0, sizeof(FILE_VIEW));
+	if (fstat(fd, &st) == -1) {
+		return -1;
+	}
+	if (!S_ISREG(st.st_mode) || offset > st.st_size) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (len == 0 || len > (U64)(st.st_size - offset))
+		len = st.st_size - offset;
+	view->flags = flags;
+	if (len == 0) {
+		view->data = (byte *)view_empty;
+		return 0;
+	}
+
+	start = offset & ~(off_t)(page - 1);
+	delta = offset - start;
+	map_len = len + delta;
+	prot = (flags & VIEW_COW) ? PROT_READ | PROT_WRITE : PROT_READ;
+	mflags = (flags & VIEW_COW) ? MAP_PRIVATE : MAP_SHARED;
+	if (flags & VIEW_POPULATE)
+		mflags |= MAP_POPULATE;
+	//ļλú͵ַҳʱں˲ôҳӳ䣬˻ͨӳ
+	map = MAP_FAILED;
+	if ((flags & VIEW_HUGE) && map_len >= VIEW_HUGE_SIZE && (start & (VIEW_HUGE_SIZE - 1)) == 0)
+		map = view_mmap_huge(map_len, prot, mflags, fd, start);
+	if (map == MAP_FAILED && (map = mmap(NULL, map_len, prot, mflags, fd, start)) == MAP_FAILED) {
+		return -1;
+	}
+#ifdef MADV_HUGEPAGE
+	if (flags & VIEW_HUGE)
+		madvise(map, map_len, MADV_HUGEPAGE);
+#endif
+	//ʾʧܲӰʹ
+	advice = (flags & VIEW_SEQUENTIAL) ? MADV_SEQUENTIAL : (flags & VIEW_RANDOM) ? MADV_RANDOM : MADV_NORMAL;
+	if (advice != MADV_NORMAL)
+		madvise(map, map_len, advice);
+	if (flags & VIEW_SEQUENTIAL)
+		posix_fadvise(fd, start, map_len, POSIX_FADV_SEQUENTIAL);
+	if ((flags & VIEW_WILLNEED) && !(flags & VIEW_POPULATE))
+		madvise(map, map_len, MADV_WILLNEED);
+
+	view->map = map;
+	view->map_len = map_len;
+	view->data = (byte *)map + delta;
+	view->len = len;
+	return 0;
+}
+
+/**
+ * @brief ӳļ
+ * 
+ * @return ɹ0ʧܷ-1errno
+ */
+int file_view_open(FILE_VIEW *view, const char *path, int flags)
+{
+	int fd, iRet, err;
+
+	if (!path) {
+		errno = EBADF;
+		return -1;
+	}
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1) {
+		return -1;
+	}
+	iRet = file_view_map(view, fd, 0, 0, flags);
+	err = errno;
+	close(fd);
+	errno = err;
+	return iRet;
+}
+
+/**
+ * @brief ʾͼеһΣ˳ɨʱڴǰʱԤһΡ
+ */
+int file_view_advise(FILE_VIEW *view, size_t offset, size_t len, int advice)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	uintptr_t begin, end;
+
+	if (!view || offset > view->len) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (!view->map)
+		return 0;
+	if (len == 0 || len > view->len - offset)
+		len = view->len - offset;
+	begin = (uintptr_t)(view->data + offset) & ~(uintptr_t)(page - 1);
+	end = (uintptr_t)(view->data + offset + len);
+	return madvise((void *)begin, end - begin, advice);
+}
+
+void file_view_close(FILE_VIEW *view)
+{
+	if (view && view->map) {
+		munmap(view->map, view->map_len);
+	}
+	if (view)
+		memset(view, 0, sizeof(FILE_VIEW));
+}
+
+/*
+ * д
+ * 水BUFFER_ALIGN룬FILE_IO_DIRECTʱO_DIRECTƹҳ棬ÿζд飻
+ * ļϵͳ֧O_DIRECTʣݲһʱȥO_DIRECTٶд
+ */
+static int file_io_buffer(byte **buf, size_t *size)
+{
+	if (*size == 0)
+		*size = FILE_IO_BUFFER;
+	*size = (*size + BUFFER_ALIGN - 1) & ~(size_t)(BUFFER_ALIGN - 1);
+	if (posix_memalign((void **)buf, BUFFER_ALIGN, *size) != 0) {
+		*buf = NULL;
+		errno = ENOMEM;
+		return -1;
+	}
+	return 0;
+}
+
+//ȥO_DIRECT֮ͨʽд
+static void file_io_undirect(int fd, int *flags)
+{
+	int fl;
+
+	if ((fl = fcntl(fd, F_GETFL)) != -1 && (fl & O_DIRECT))
+		fcntl(fd, F_SETFL, fl & ~O_DIRECT);
+	*flags &= ~FILE_IO_DIRECT;
+}
+
+static int file_io_open(const char *path, int oflag, mode_t mode, int *flags)
+{
+	int fd;
+
+	if (!path) {
+		errno = EBADF;
+		return -1;
+	}
+	oflag |= O_CLOEXEC;
+	if (*flags & FILE_IO_DIRECT) {
+		if ((fd = open(path, oflag | O_DIRECT, mode)) != -1 || errno != EINVAL)
+			return fd;
+		*flags &= ~FILE_IO_DIRECT;
+	}
+	return open(path, oflag, mode);
+}
+
+/**
+ * @brief Ѵ򿪵ļϽд棬fdɵ߹رա
+ * 
+ * @param size С0ΪFILE_IO_BUFFERBUFFER_ALIGNȡ
+ * @param flags FILE_IO_DIRECTʱfdӦO_DIRECT򿪣ļλð롣
+ * 
+ * @return ɹ0ʧܷ-1
+ */
+int file_writer_init(FILE_WRITER *w, int fd, size_t size, int flags)
+{
+	memset(w, 0, sizeof(FILE_WRITER));
+	w->fd = fd;
+	w->flags = flags;
+	w->size = size;
+	return file_io_buffer(&w->buf, &w->size);
+}
+
+/**
+ * @brief ļд棬file_writer_closeʱرļ
+ * 
+ * @param oflag openı־O_WRONLY
+ * 
+ * @return ɹ0ʧܷ-1
+ */
+int file_writer_open(FILE_WRITER *w, const char *path, int oflag, mode_t mode, size_t size, int flags)
+{
+	int fd, err;
+
+	if ((fd = file_io_open(path, oflag | O_WRONLY, mode, &flags)) == -1) {
+		return -1;
+	}
+	if (file_writer_init(w, fd, size, flags) == -1) {
+		err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	w->owned = 1;
+	return 0;
+}
+
+//ͬдݣеĲд
+static int file_writer_datasync(FILE_WRITER *w)
+{
+	if (w->unsynced == 0)
+		return 0;
+	while (fdatasync(w->fd) == -1) {
+		if (errno != EINTR)
+			return -1;
+	}
+	w->unsynced = 0;
+	w->syncs++;
+	return 0;
+}
+
+//д棬dataΪʱͻϲΪһwritev
+static int file_writer_out(FILE_WRITER *w, const void *data, size_t len, int all)
+{
+	struct iovec iov[2];
+	size_t n = w->len;
+	ssize_t ret;
+
+	if (w->flags & FILE_IO_DIRECT) {
+		//O_DIRECTֻд飬һβڻ
+		if (!all)
+			n &= ~(size_t)(BUFFER_ALIGN - 1);
+		else if (n & (BUFFER_ALIGN - 1))
+			file_io_undirect(w->fd, &w->flags);
+	}
+	iov[0].iov_base = w->buf;
+	iov[0].iov_len = n;
+	iov[1].iov_base = (void *)data;
+	iov[1].iov_len = len;
+	if ((ret = writev_full(w->fd, iov, data ? 2 : 1)) == -1) {
+		if (errno != EINVAL || !(w->flags & FILE_IO_DIRECT))
+			return -1;
+		//ļλû򳤶ȲO_DIRECTĶҪ
+		file_io_undirect(w->fd, &w->flags);
+		iov[0].iov_base = w->buf;
+		iov[0].iov_len = n;
+		iov[1].iov_base = (void *)data;
+		iov[1].iov_len = len;
+		if ((ret = writev_full(w->fd, iov, data ? 2 : 1)) == -1)
+			return -1;
+	}
+	w->writes++;
+	if (n < w->len)
+		memmove(w->buf, w->buf + n, w->len - n);
+	w->len -= n;
+	w->unsynced += ret;
+	if (w->sync_bytes && w->unsynced >= w->sync_bytes)
+		return file_writer_datasync(w);
+	return 0;
+}
+
+/**
+ * @brief ׷ݡŵʱֻƵ棻Ųʱһwritevд
+ * O_DIRECTʱݾ水д
+ * 
+ * @return ɹlenʧܷ-1
+ */
+ssize_t file_write(FILE_WRITER *w, const void *data, size_t len)
+{
+	const byte *p = (const byte *)data;
+	size_t n, left = len;
+
+	if (len <= w->size - w->len) {
+		memcpy(w->buf + w->len, data, len);
+		w->len += len;
+		return len;
+	}
+	if (!(w->flags & FILE_IO_DIRECT)) {
+		//ŲʱСȴддСݿ
+		if (len < w->size) {
+			n = w->size - w->len;
+			memcpy(w->buf + w->len, p, n);
+			w->len += n;
+			if (file_writer_out(w, NULL, 0, 1) == -1)
+				return -1;
+			memcpy(w->buf, p + n, len - n);
+			w->len = len - n;
+			return len;
+		}
+		return file_writer_out(w, data, len, 1) == -1 ? -1 : (ssize_t)len;
+	}
+	while (left > 0) {
+		n = w->size - w->len < left ? w->size - w->len : left;
+		memcpy(w->buf + w->len, p, n);
+		w->len += n;
+		p += n;
+		left -= n;
+		if (w->len == w->size && file_writer_out(w, NULL, 0, 0) == -1)
+			return -1;
+	}
+	return len;
+}
+
+/**
+ * @brief ׷ӶݣСθƵ棬ŲʱͻϲΪһwritev
+ * 
+ * @return ɹֽʧܷ-1
+ */
+ssize_t file_writev(FILE_WRITER *w, const struct iovec *iov, int cnt)
+{
+	struct iovec vec[FILE_IO_IOV];
+	size_t total = 0;
+	ssize_t ret;
+	int i, k;
+
+	for (i = 0; i < cnt; i++)
+		total += iov[i].iov_len;
+	if ((w->flags & FILE_IO_DIRECT) || total <= w->size - w->len) {
+		for (i = 0; i < cnt; i++) {
+			if (file_write(w, iov[i].iov_base, iov[i].iov_len) == -1)
+				return -1;
+		}
+		return total;
+	}
+	for (i = 0; i < cnt; i += k) {
+		vec[0].iov_base = w->buf;
+		vec[0].iov_len = w->len;
+		for (k = 0; k < FILE_IO_IOV - 1 && i + k < cnt; k++)
+			vec[k + 1] = iov[i + k];
+		if ((ret = writev_full(w->fd, vec, k + 1)) == -1)
+			return -1;
+		w->writes++;
+		w->len = 0;
+		w->unsynced += ret;
+	}
+	if (w->sync_bytes && w->unsynced >= w->sync_bytes && file_writer_datasync(w) == -1)
+		return -1;
+	return total;
+}
+
+int file_writer_flush(FILE_WRITER *w)
+{
+	if (w->len == 0)
+		return 0;
+	return file_writer_out(w, NULL, 0, 1);
+}
+
+/**
+ * @brief д沢fdatasyncO_DIRECTʱһβͨʽд֮O_DIRECT
+ * sync_bytesʱдۼƵֵԶͬһΣеݣ
+ */
+int file_writer_sync(FILE_WRITER *w)
+{
+	if (w->len && file_writer_out(w, NULL, 0, 1) == -1)
+		return -1;
+	return file_writer_datasync(w);
+}
+
+/**
+ * @brief д沢ͷţsync_bytesΪ0ʱͬfile_writer_open򿪵ļͬʱرա
+ * 
+ * @return ɹ0һʧܷ-1Դȫͷš
+ */
+int file_writer_close(FILE_WRITER *w)
+{
+	int iRet = 0, err = 0;
+
+	if ((w->sync_bytes ? file_writer_sync(w) : file_writer_flush(w)) == -1) {
+		iRet = -1;
+		err = errno;
+	}
+	if (w->owned && close(w->fd) == -1 && iRet == 0) {
+		iRet = -1;
+		err = errno;
+	}
+	free(w->buf);
+	w->buf = NULL;
+	w->fd = -1;
+	if (iRet == -1)
+		errno = err;
+	return iRet;
+}
+
+/**
+ * @brief Ѵ򿪵ļϽ棬fdɵ߹رա
+ * 
+ * @param size С0ΪFILE_IO_BUFFERBUFFER_ALIGNȡ
+ * @param flags FILE_IO_DIRECTʱfdӦO_DIRECT򿪡
+ * 
+ * @return ɹ0ʧܷ-1
+ */
+int file_reader_init(FILE_READER *r, int fd, size_t size, int flags)
+{
+	memset(r, 0, sizeof(FILE_READER));
+	r->fd = fd;
+	r->flags = flags;
+	r->size = size;
+	return file_io_buffer(&r->buf, &r->size);
+}
+
+int file_reader_open(FILE_READER *r, const char *path, size_t size, int flags)
+{
+	int fd, err;
+
+	if ((fd = file_io_open(path, O_RDONLY, 0, &flags)) == -1) {
+		return -1;
+	}
+	if (file_reader_init(r, fd, size, flags) == -1) {
+		err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	r->owned = 1;
+	if (!(flags & FILE_IO_DIRECT))
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	return 0;
+}
+
+//պ䣬ضֽ
+static ssize_t file_reader_fill(FILE_READER *r)
+{
+	ssize_t n;
+
+	r->pos = r->len = 0;
+	while ((n = read(r->fd, r->buf, r->size)) == -1) {
+		if (errno == EINTR)
+			continue;
+		if (errno != EINVAL || !(r->flags & FILE_IO_DIRECT))
+			return -1;
+		file_io_undirect(r->fd, &r->flags);
+	}
+	r->reads++;
+	r->len = n;
+	return n;
+}
+
+/**
+ * @brief ػпɶݣƣΪʱȶ롣file_reader_skipѡ
+ * 
+ * @return ɶֽļ0ʧܷ-1
+ */
+ssize_t file_peek(FILE_READER *r, const byte **data)
+{
+	ssize_t n;
+
+	if (r->pos == r->len && (n = file_reader_fill(r)) <= 0)
+		return n;
+	*data = r->buf + r->pos;
+	return r->len - r->pos;
+}
+
+void file_reader_skip(FILE_READER *r, size_t len)
+{
+	r->pos = len < r->len - r->pos ? r->pos + len : r->len;
+}
+
+/**
+ * @brief ȡlenֽڡΪlenСڻСʱֱӶbufO_DIRECTʱ⡣
+ * 
+ * @return ֽļ0ʧܷ-1
+ */
+ssize_t file_read(FILE_READER *r, void *buf, size_t len)
+{
+	byte *p = (byte *)buf;
+	size_t total = 0, n;
+	ssize_t ret;
+
+	while (total < len) {
+		if (r->pos == r->len) {
+			if (!(r->flags & FILE_IO_DIRECT) && len - total >= r->size) {
+				if ((ret = read(r->fd, p + total, len - total)) == -1) {
+					if (errno == EINTR)
+						continue;
+					return total ? (ssize_t)total : -1;
+				}
+				r->reads++;
+				if (ret == 0)
+					break;
+				total += ret;
+				continue;
+			}
+			if ((ret = file_reader_fill(r)) <= 0) {
+				if (ret == -1 && total == 0)
+					return -1;
+				break;
+			}
+		}
+		n = r->len - r->pos < len - total ? r->len - r->pos : len - total;
+		memcpy(p + total, r->buf + r->pos, n);
+		r->pos += n;
+		total += n;
+	}
+	return total;
+}
+
+int file_reader_close(FILE_READER *r)
+{
+	int iRet = 0;
+
+	if (r->owned)
+		iRet = close(r->fd);
+	free(r->buf);
+	r->buf = NULL;
+	r->fd = -1;
+	return iRet;
+}
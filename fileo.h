@@ -10,9 +10,133 @@
 #define __FILEO_H__
 
 #include "types.h"
+#include <sys/types.h>
+#include <sys/uio.h>
 
-int copy_file(const char *from_file, const char *to_file);
-int copy_dir(const char *from_path, const char *to_path);
+/** @brief copy_dirxĬ߳ */
+#define COPY_THREADS_MAX 64
+
+/** @brief ͬģʽĿļС޸ʱԴͬʱʱļƺ滻 */
+#define COPY_SYNC 0x01
+/** @brief ͬģʽ´СʱͬʱȽ */
+#define COPY_COMPARE 0x02
+/** @brief FICLONEݿ飨XFSbtrfsȣ֧ʱ */
+#define COPY_CLONE 0x04
+/** @brief ȽָԴļӲӣֻֻݣļϵͳ¸ */
+#define COPY_LINK 0x08
+/** @brief copy_dirxio_uringͬʱдСļʱͨʽ */
+#define COPY_URING 0x10
+
+/** @brief ļʵʲõĸƷʽ(COPY_METHOD) */
+typedef enum {
+	COPY_COPIED,		/* дںڸ */
+	COPY_CLONED,		/* FICLONEݿ */
+	COPY_LINKED			/* Ӳ */
+}COPY_METHOD;
+
+/** @brief Ŀ¼ͳ(COPY_STAT)ƹԭӸ */
+typedef struct {
+	U64 bytes;			/* Ѹֽ */
+	U64 files;			/* Ѹļ */
+	U64 dirs;			/* ½Ŀ¼ */
+	U64 errors;			/* ʧܵĿ */
+	U64 skipped;		/* ͬģʽδ仯ļ */
+	U64 cloned;			/* ¡ļfiles */
+	U64 linked;			/* Ӳӵļfiles */
+	U64 shared;			/* ¡Ӳӵֽbytesûʵʶд */
+}COPY_STAT;
+
+/** @brief Ŀ¼(COPY_TASK) */
+typedef struct {
+	int threads;		/* ߳0ΪCPU */
+	int flags;			/* COPY_SYNCCOPY_COMPARECOPY_CLONECOPY_LINKCOPY_URING */
+	int depth;			/* COPY_URINGʱÿ̵߳ĶȣͬʱƵļ0Ϊ32 */
+	const char *manifest;	/* ͬ嵥ļΪգcopy_dirx */
+	int cancel;			/* copy_cancelãcopy_dirxǰ0 */
+	int err;			/* һerrno */
+	COPY_STAT stat;
+}COPY_TASK;
+
+/** @brief ˽пдӳ䣬޸Ĳдļ */
+#define VIEW_COW 0x01
+/** @brief ӳʱԤȶȫҳ(MAP_POPULATE) */
+#define VIEW_POPULATE 0x02
+/** @brief ˳ʣӴԤ */
+#define VIEW_SEQUENTIAL 0x04
+/** @brief ʣرԤ */
+#define VIEW_RANDOM 0x08
+/** @brief ӳʼ첽Ԥ */
+#define VIEW_WILLNEED 0x10
+/** @brief ҳ벢ʹ͸ҳ֧ʱΪͨӳ */
+#define VIEW_HUGE 0x20
+/** @brief VIEW_HUGEĶС */
+#define VIEW_HUGE_SIZE (2UL * 1024 * 1024)
+
+/** @brief ļӳͼ(FILE_VIEW) */
+typedef struct {
+	byte *data;			/* ͼʼַļʱָֻĿջ */
+	size_t len;			/* ͼ */
+	void *map;			/* ʵӳַҳ룬ͼʱΪ */
+	size_t map_len;
+	int flags;
+}FILE_VIEW;
+
+/** @brief дĬϴС */
+#define FILE_IO_BUFFER (256 * 1024)
+/** @brief O_DIRECTƹҳ棬ļϵͳ֧ʱͨʽд */
+#define FILE_IO_DIRECT 0x01
+
+/** @brief д(FILE_WRITER) */
+typedef struct {
+	int fd;
+	int flags;			/* FILE_IO_DIRECTO_DIRECTʱ */
+	int owned;			/* file_writer_open򿪣رʱһر */
+	byte *buf;
+	size_t size;		/* С */
+	size_t len;			/* ддֽ */
+	size_t sync_bytes;	/* дۼƴﵽֵʱfdatasync0Ϊֻfile_writer_syncʱͬʱ޸ */
+	size_t unsynced;	/* ϴͬдֽ */
+	U64 writes;			/* write/writevô */
+	U64 syncs;			/* fdatasyncô */
+}FILE_WRITER;
+
+/** @brief (FILE_READER) */
+typedef struct {
+	int fd;
+	int flags;
+	int owned;
+	byte *buf;
+	size_t size;
+	size_t pos;			/* һδֽ */
+	size_t len;			/* еЧֽ */
+	U64 reads;			/* readô */
+}FILE_READER;
+
+S64 copy_file(const char *from_file, const char *to_file);
+S64 copy_filex(const char *from_file, const char *to_file, int flags, COPY_METHOD *method);
+S64 copy_dir(const char *from_path, const char *to_path);
+S64 copy_dirx(const char *from_path, const char *to_path, COPY_TASK *task);
+void copy_cancel(COPY_TASK *task);
+
+int file_view_open(FILE_VIEW *view, const char *path, int flags);
+int file_view_map(FILE_VIEW *view, int fd, off_t offset, size_t len, int flags);
+int file_view_advise(FILE_VIEW *view, size_t offset, size_t len, int advice);
+void file_view_close(FILE_VIEW *view);
+
+int file_writer_init(FILE_WRITER *w, int fd, size_t size, int flags);
+int file_writer_open(FILE_WRITER *w, const char *path, int oflag, mode_t mode, size_t size, int flags);
+ssize_t file_write(FILE_WRITER *w, const void *data, size_t len);
+ssize_t file_writev(FILE_WRITER *w, const struct iovec *iov, int cnt);
+int file_writer_flush(FILE_WRITER *w);
+int file_writer_sync(FILE_WRITER *w);
+int file_writer_close(FILE_WRITER *w);
+
+int file_reader_init(FILE_READER *r, int fd, size_t size, int flags);
+int file_reader_open(FILE_READER *r, const char *path, size_t size, int flags);
+ssize_t file_read(FILE_READER *r, void *buf, size_t len);
+ssize_t file_peek(FILE_READER *r, const byte **data);
+void file_reader_skip(FILE_READER *r, size_t len);
+int file_reader_close(FILE_READER *r);
 
 #endif /*__FILEO_H__*/
 
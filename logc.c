@@ -7,15 +7,685 @@
  * @brief ־ӿڡ
  *
  * ֱ־LOGӿڣҪָ־ļLOGNӿڣҪչ־ӿvLOGNӿڡ
+ * log_async_start־תΪ첽ֻ߳ʽУɺ̨߳дļ
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
 #include "timeo.h"
 #include "logc.h"
 
+/** @brief ־ͷȼʱ䡢ԴļλãԤ */
+#define LOG_HEAD_SIZE (LOG_PATH_MAX + 100)
+/** @brief ַ(yyyy-mm-dd) */
+#define LOG_DATE_SIZE 11
+
+/** @brief 첽־¼ */
+typedef struct {
+	unsigned long seq;				/* λţ̨߳̾ݴ˽ */
+	int level;
+	int len;
+	char *data;						/* ¼ݣָlineڴ */
+	time_t time;					/* ¼ʱ䣬дһļ */
+	char name[LOG_NAME_MAX + 1];
+	char line[LOG_ASYNC_LINE];
+}LOG_RECORD;
+
+/** @brief Ѵ򿪵־ļ */
+typedef struct {
+	char name[LOG_NAME_MAX + 1];
+	char date[LOG_DATE_SIZE];
+	int fd;
+	int seq;						/* תţ0Ϊŵļ */
+	off_t size;
+	time_t day_start, day_end;		/* ļڵֹʱ */
+	unsigned long used;
+}LOG_FILE;
+
+static LOG_RECORD *log_recs = NULL;
+static unsigned long log_mask = 0;
+static unsigned long log_enq_pos __attribute__((aligned(64))) = 0;	/* λ */
+static unsigned long log_deq_pos __attribute__((aligned(64))) = 0;	/* ̨߳λ */
+static unsigned long log_written = 0;
+static unsigned long log_dropped = 0;
+static int log_running = 0, log_started = 0, log_inflight = 0;
+static int log_sleeping = 0, log_waiters = 0;
+static LOG_OVERFLOW log_policy = LOG_OVERFLOW_BLOCK;
+static pthread_t log_thread;
+static pthread_mutex_t log_ctl = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t log_space = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t log_done = PTHREAD_COND_INITIALIZER;
+
+/** @brief õȼ־ƣȼlog_level_valueУ±1 */
+typedef struct {
+	char name[LOG_NAME_MAX + 1];
+}LOG_LEVEL_NAME;
+
+int log_level_max = LOG_UNKNOWN;
+int log_level_value[LOG_LEVEL_NAMES + 1] = {LOG_UNKNOWN};
+unsigned log_level_gen = 1;
+static int log_level_count = 0;
+static LOG_LEVEL_NAME log_levels[LOG_LEVEL_NAMES];
+static pthread_mutex_t log_level_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread SFTIME_FMT log_ts;	/* ÿ̻߳Եʱǰ׺ */
+static LOG_FILE log_files[LOG_FILE_CACHE];
+static unsigned long log_file_tick = 0;
+static int log_file_ready = 0;
+static off_t log_max_size = 0;
+static pthread_mutex_t log_file_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief ȴȴms롣ǰlog_lock
+ */
+static void log_timedwait(pthread_cond_t *cond, const int ms)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += (long)ms * 1000000L;
+	ts.tv_sec += ts.tv_nsec / 1000000000L;
+	ts.tv_nsec %= 1000000000L;
+	pthread_cond_timedwait(cond, &log_lock, &ts);
+}
+
+/**
+ * @brief дiov飬EINTR벿д
+ */
+static int log_writev(int fd, struct iovec *iov, int cnt)
+{
+	ssize_t n;
+
+	while (cnt > 0) {
+		n = writev(fd, iov, cnt);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		while (cnt > 0 && (size_t)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief ־ȼȼֵڸֵ־ʱá
+ *
+ * @param name ־ļƣΪNULLʱδõȼȫ־ļĬϵȼ
+ * @param level ־ȼ
+ *
+ * @return ɹ0õƹ෵-1
+ */
+int log_set_level(const char *name, const int level)
+{
+	int i, count, max;
+
+	pthread_mutex_lock(&log_level_lock);
+	count = log_level_count;
+	if (name == NULL) {
+		__atomic_store_n(&log_level_value[0], level, __ATOMIC_RELAXED);
+	} else {
+		for (i = 0; i < count; i++) {
+			if (strcmp(log_levels[i].name, name) == 0) {
+				break;
+			}
+		}
+		if (i == count) {
+			if (count == LOG_LEVEL_NAMES) {
+				pthread_mutex_unlock(&log_level_lock);
+				errno = ENOMEM;
+				return -1;
+			}
+			snprintf(log_levels[i].name, sizeof(log_levels[i].name), "%s", name);
+			__atomic_store_n(&log_level_value[i + 1], level, __ATOMIC_RELAXED);
+			__atomic_store_n(&log_level_count, ++count, __ATOMIC_RELEASE);
+			//Ƶ±ĶӦϵˣõ㻺ȫ½
+			__atomic_add_fetch(&log_level_gen, 1, __ATOMIC_RELEASE);
+		}
+		__atomic_store_n(&log_level_value[i + 1], level, __ATOMIC_RELAXED);
+	}
+	max = log_level_value[0];
+	for (i = 1; i <= count; i++) {
+		if (log_level_value[i] > max) {
+			max = log_level_value[i];
+		}
+	}
+	__atomic_store_n(&log_level_max, max, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&log_level_lock);
+	return 0;
+}
+
+/**
+ * @brief ȡlog_level_valueе±꣬ûеʱΪ0Ĭϵȼ
+ * ư־ļͬضϺȽϣΪNULLʱͬ"log"
+ */
+static int log_level_slot(const char *name)
+{
+	char file_name[LOG_NAME_MAX + 1];
+	int i, count;
+
+	snprintf(file_name, sizeof(file_name), "%s", name ? name : "log");
+	count = __atomic_load_n(&log_level_count, __ATOMIC_ACQUIRE);
+	for (i = 0; i < count; i++) {
+		if (strcmp(log_levels[i].name, file_name) == 0) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief ȡ־ļǰڵȼ
+ *
+ * @param name ־ļƣΪNULLʱȡĬϵȼ
+ *
+ * @return ־ȼ
+ */
+int log_get_level(const char *name)
+{
+	return __atomic_load_n(&log_level_value[name ? log_level_slot(name) : 0], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief õ־Ʋ棬LOG_SITE_SLOTڻʧЧʱá
+ *
+ * @return log_level_valueе±ꡣ
+ */
+int log_site_resolve(LOG_SITE *site, const char *name)
+{
+	//ȡٲңڼʱ´εû½
+	site->gen = __atomic_load_n(&log_level_gen, __ATOMIC_ACQUIRE);
+	site->slot = log_level_slot(name);
+	site->name = name;
+	return site->slot;
+}
+
+/**
+ * @brief tڵֹʱַ(yyyy-mm-dd)
+ */
+static void log_file_day(LOG_FILE *f, const time_t t)
+{
+	struct tm tm;
+
+	localtime_r(&t, &tm);
+	strftime(f->date, sizeof(f->date), "%Y-%m-%d", &tm);
+	tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+	tm.tm_isdst = -1;
+	f->day_start = mktime(&tm);
+	tm.tm_mday++;
+	tm.tm_isdst = -1;
+	f->day_end = mktime(&tm);
+}
+
+/**
+ * @brief 򿪻Ӧ־ļдתļ
+ */
+static int log_file_open(LOG_FILE *f, const size_t len)
+{
+	char FilePath[LOG_PATH_MAX + 1];
+	struct stat st;
+
+	for (;;) {
+		if (f->seq == 0) {
+			snprintf(FilePath, sizeof(FilePath), "%s%s.%s.log", LOG_PATH, f->name, f->date);
+		} else {
+			snprintf(FilePath, sizeof(FilePath), "%s%s.%s.%d.log", LOG_PATH, f->name, f->date, f->seq);
+		}
+		if ((f->fd = open(FilePath, O_WRONLY | O_APPEND | O_CREAT, 0666)) == -1) {
+			return -1;
+		}
+		f->size = (fstat(f->fd, &st) == 0) ? st.st_size : 0;
+		if (log_max_size == 0 || f->size == 0 || f->size + (off_t)len <= log_max_size) {
+			return 0;
+		}
+		close(f->fd);
+		f->fd = -1;
+		f->seq++;
+	}
+}
+
+/**
+ * @brief ȡ־ļջ򳬹Сʱ´ļǰlog_file_lock
+ *
+ * @param name ־ļơ
+ * @param t ¼ʱ䡣
+ * @param len дֽ
+ *
+ * @return ʧܷNULL
+ */
+static LOG_FILE *log_file_get(const char *name, const time_t t, const size_t len)
+{
+	int i;
+	LOG_FILE *f = NULL, *lru = &log_files[0];
+
+	for (i = 0; i < LOG_FILE_CACHE; i++) {
+		if (log_files[i].fd != -1 && strcmp(log_files[i].name, name) == 0) {
+			f = &log_files[i];
+			break;
+		}
+		if (log_files[i].fd == -1 || (lru->fd != -1 && log_files[i].used < lru->used)) {
+			lru = &log_files[i];
+		}
+	}
+	if (f) {
+		f->used = ++log_file_tick;
+		if (t < f->day_start || t >= f->day_end) {
+			close(f->fd);
+			f->seq = 0;
+			log_file_day(f, t);
+		} else if (log_max_size && f->size && f->size + (off_t)len > log_max_size) {
+			close(f->fd);
+			f->seq++;
+		} else {
+			return f;
+		}
+	} else {
+		f = lru;
+		if (f->fd != -1) {
+			close(f->fd);
+		}
+		snprintf(f->name, sizeof(f->name), "%s", name);
+		f->seq = 0;
+		f->used = ++log_file_tick;
+		log_file_day(f, t);
+	}
+	if (log_file_open(f, len) == -1) {
+		f->fd = -1;
+		return NULL;
+	}
+	return f;
+}
+
+/**
+ * @brief дͬһ־ļһ¼ںʹС޲Ϊɴwritev
+ *
+ * @param name ־ļơ
+ * @param times ÿ¼ʱ䡣
+ * @param iov ÿ¼ݡ
+ * @param cnt ¼
+ */
+static void log_file_write(const char *name, const time_t *times, struct iovec *iov, const int cnt)
+{
+	int i, j;
+	size_t bytes;
+	LOG_FILE *f;
+
+	pthread_mutex_lock(&log_file_lock);
+	if (!log_file_ready) {
+		for (i = 0; i < LOG_FILE_CACHE; i++) {
+			log_files[i].fd = -1;
+		}
+		log_file_ready = 1;
+	}
+	for (i = 0; i < cnt; i = j) {
+		if ((f = log_file_get(name, times[i], iov[i].iov_len)) == NULL) {
+			j = i + 1;
+			continue;
+		}
+		bytes = iov[i].iov_len;
+		for (j = i + 1; j < cnt; j++) {
+			if (times[j] < f->day_start || times[j] >= f->day_end) {
+				break;
+			}
+			if (log_max_size && f->size + (off_t)(bytes + iov[j].iov_len) > log_max_size) {
+				break;
+			}
+			bytes += iov[j].iov_len;
+		}
+		if (log_writev(f->fd, iov + i, j - i) == 0) {
+			f->size += bytes;
+		} else {
+			//дʧʱرļ´´
+			close(f->fd);
+			f->fd = -1;
+		}
+	}
+	pthread_mutex_unlock(&log_file_lock);
+}
+
+/**
+ * @brief õ־ļĴСޣתŵļ(name.yyyy-mm-dd.N.log)
+ *
+ * @param size Сޣֽڣ0ʾơ
+ */
+void log_set_max_size(const off_t size)
+{
+	pthread_mutex_lock(&log_file_lock);
+	log_max_size = size > 0 ? size : 0;
+	pthread_mutex_unlock(&log_file_lock);
+}
+
+/**
+ * @brief رջȫ־ļ´д־ʱ´򿪡
+ */
+void log_close(void)
+{
+	int i;
+
+	pthread_mutex_lock(&log_file_lock);
+	if (log_file_ready) {
+		for (i = 0; i < LOG_FILE_CACHE; i++) {
+			if (log_files[i].fd != -1) {
+				close(log_files[i].fd);
+				log_files[i].fd = -1;
+			}
+		}
+	}
+	pthread_mutex_unlock(&log_file_lock);
+}
+
+/**
+ * @brief ̨߳ȡһѾļ¼дļ
+ *
+ * @return δļ¼
+ */
+static int log_async_drain(void)
+{
+	int cnt = 0, i, j, k;
+	unsigned long pos = log_deq_pos;
+	LOG_RECORD *recs[LOG_ASYNC_BATCH], *rec;
+	time_t times[LOG_ASYNC_BATCH];
+	struct iovec iov[LOG_ASYNC_BATCH];
+
+	while (cnt < LOG_ASYNC_BATCH) {
+		rec = &log_recs[(pos + cnt) & log_mask];
+		if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != pos + cnt + 1) {
+			break;
+		}
+		recs[cnt++] = rec;
+	}
+	if (cnt == 0) {
+		return 0;
+	}
+	for (i = 0; i < cnt; i = j) {
+		for (j = i; j < cnt && strcmp(recs[j]->name, recs[i]->name) == 0; j++) {
+			k = j - i;
+			times[k] = recs[j]->time;
+			iov[k].iov_base = recs[j]->data;
+			iov[k].iov_len = recs[j]->len;
+		}
+		log_file_write(recs[i]->name, times, iov, j - i);
+	}
+	for (i = 0; i < cnt; i++) {
+		if (recs[i]->data != recs[i]->line) {
+			free(recs[i]->data);
+		}
+		__atomic_store_n(&recs[i]->seq, pos + i + log_mask + 1, __ATOMIC_RELEASE);
+	}
+	log_deq_pos = pos + cnt;
+	pthread_mutex_lock(&log_lock);
+	log_written = log_deq_pos;
+	pthread_cond_broadcast(&log_done);
+	if (log_waiters) {
+		pthread_cond_broadcast(&log_space);
+	}
+	pthread_mutex_unlock(&log_lock);
+	return cnt;
+}
+
+static int log_async_empty(void)
+{
+	LOG_RECORD *rec = &log_recs[log_deq_pos & log_mask];
+	return __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != log_deq_pos + 1;
+}
+
+/**
+ * @brief ̨д־ֹ̡߳ͣдʣļ¼˳
+ */
+static void *log_async_run(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		if (log_async_drain() > 0) {
+			continue;
+		}
+		if (!__atomic_load_n(&log_running, __ATOMIC_SEQ_CST)
+			&& __atomic_load_n(&log_inflight, __ATOMIC_SEQ_CST) == 0) {
+			if (log_async_empty()) {
+				break;
+			}
+			continue;
+		}
+		pthread_mutex_lock(&log_lock);
+		__atomic_store_n(&log_sleeping, 1, __ATOMIC_SEQ_CST);
+		if (log_async_empty() && __atomic_load_n(&log_running, __ATOMIC_SEQ_CST)) {
+			log_timedwait(&log_wake, 100);
+		}
+		__atomic_store_n(&log_sleeping, 0, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&log_lock);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Ѹʽõ־첽С
+ *
+ * @return 0ӻ򰴲Զ-1첽ģʽδͬд
+ */
+static int log_async_put(const char *name, const time_t t, const int level, const char *line, const int len)
+{
+	long diff;
+	unsigned long pos, seq;
+	LOG_RECORD *rec;
+
+	__atomic_add_fetch(&log_inflight, 1, __ATOMIC_SEQ_CST);
+	if (!__atomic_load_n(&log_running, __ATOMIC_SEQ_CST)) {
+		__atomic_sub_fetch(&log_inflight, 1, __ATOMIC_SEQ_CST);
+		return -1;
+	}
+	for (;;) {
+		pos = __atomic_load_n(&log_enq_pos, __ATOMIC_RELAXED);
+		rec = &log_recs[pos & log_mask];
+		seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+		diff = (long)(seq - pos);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&log_enq_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			//
+			if (log_policy == LOG_OVERFLOW_DROP || (log_policy == LOG_OVERFLOW_DROP_LOW && level >= LOG_NOTICE)) {
+				__atomic_add_fetch(&log_dropped, 1, __ATOMIC_RELAXED);
+				__atomic_sub_fetch(&log_inflight, 1, __ATOMIC_SEQ_CST);
+				return 0;
+			}
+			pthread_mutex_lock(&log_lock);
+			log_waiters++;
+			pthread_cond_signal(&log_wake);
+			log_timedwait(&log_space, 10);
+			log_waiters--;
+			pthread_mutex_unlock(&log_lock);
+		}
+	}
+	rec->level = level;
+	rec->time = t;
+	strcpy(rec->name, name);
+	rec->data = rec->line;
+	rec->len = len;
+	if (len > LOG_ASYNC_LINE && (rec->data = (char *)malloc(len)) == NULL) {
+		//ڴ治ʱضϵǶ
+		rec->data = rec->line;
+		rec->len = LOG_ASYNC_LINE;
+	}
+	memcpy(rec->data, line, rec->len);
+	rec->data[rec->len - 1] = '\n';
+	__atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+	__atomic_sub_fetch(&log_inflight, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&log_sleeping, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&log_lock);
+		pthread_cond_signal(&log_wake);
+		pthread_mutex_unlock(&log_lock);
+	}
+	return 0;
+}
+
+/**
+ * @brief 첽־
+ *
+ * @param capacity ȡΪ2ݣСڵ0ʱʹLOG_ASYNC_CAPACITY
+ * @param policy ʱĴԡ
+ *
+ * @return ɹ0ʧܷ-1
+ */
+int log_async_start(const int capacity, const LOG_OVERFLOW policy)
+{
+	static int registered = 0;
+	unsigned long i, size = 2;
+
+	pthread_mutex_lock(&log_ctl);
+	if (log_started) {
+		pthread_mutex_unlock(&log_ctl);
+		errno = EBUSY;
+		return -1;
+	}
+	while (size < (unsigned long)(capacity > 0 ? capacity : LOG_ASYNC_CAPACITY)) {
+		size <<= 1;
+	}
+	if ((log_recs = (LOG_RECORD *)malloc(size * sizeof(LOG_RECORD))) == NULL) {
+		pthread_mutex_unlock(&log_ctl);
+		errno = ENOMEM;
+		return -1;
+	}
+	for (i = 0; i < size; i++) {
+		log_recs[i].seq = i;
+	}
+	log_mask = size - 1;
+	log_enq_pos = log_deq_pos = log_written = 0;
+	log_policy = policy;
+	__atomic_store_n(&log_running, 1, __ATOMIC_SEQ_CST);
+	if (pthread_create(&log_thread, NULL, log_async_run, NULL) != 0) {
+		__atomic_store_n(&log_running, 0, __ATOMIC_SEQ_CST);
+		free(log_recs);
+		log_recs = NULL;
+		pthread_mutex_unlock(&log_ctl);
+		return -1;
+	}
+	log_started = 1;
+	if (!registered) {
+		atexit(log_async_stop);
+		registered = 1;
+	}
+	pthread_mutex_unlock(&log_ctl);
+	return 0;
+}
+
+/**
+ * @brief ȴǰύ첽־ȫдļ
+ *
+ * @return ɹ0
+ */
+int log_async_flush(void)
+{
+	unsigned long target;
+
+	pthread_mutex_lock(&log_ctl);
+	if (!log_started) {
+		pthread_mutex_unlock(&log_ctl);
+		return 0;
+	}
+	target = __atomic_load_n(&log_enq_pos, __ATOMIC_ACQUIRE);
+	pthread_mutex_lock(&log_lock);
+	pthread_cond_signal(&log_wake);
+	while ((long)(log_written - target) < 0) {
+		pthread_cond_wait(&log_done, &log_lock);
+	}
+	pthread_mutex_unlock(&log_lock);
+	pthread_mutex_unlock(&log_ctl);
+	return 0;
+}
+
+/**
+ * @brief ֹͣ첽־деȫ¼󷵻أ֮־ָͬ
+ */
+void log_async_stop(void)
+{
+	pthread_mutex_lock(&log_ctl);
+	if (!log_started) {
+		pthread_mutex_unlock(&log_ctl);
+		return;
+	}
+	pthread_mutex_lock(&log_lock);
+	__atomic_store_n(&log_running, 0, __ATOMIC_SEQ_CST);
+	pthread_cond_signal(&log_wake);
+	pthread_mutex_unlock(&log_lock);
+	pthread_join(log_thread, NULL);
+	free(log_recs);
+	log_recs = NULL;
+	log_started = 0;
+	pthread_mutex_unlock(&log_ctl);
+}
+
+/**
+ * @brief ضʱ־
+ */
+unsigned long log_async_dropped(void)
+{
+	return __atomic_load_n(&log_dropped, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief ʽдһ־жϹȼ
+ */
+static void log_vwrite(const char *name, const int level, const char *file, const int line, const char *format, va_list args)
+{
+	int len, n;
+	char buf[LOG_HEAD_SIZE + LOG_SIZE + 2], file_name[LOG_NAME_MAX + 1];
+	char ts[50];
+	time_t now;
+	struct iovec iov;
+
+	if (name == NULL) {
+		strcpy(file_name, "log");
+	} else {
+		snprintf(file_name, sizeof(file_name), "%s", name);
+	}
+	if (log_ts.len == 0) {
+		sftime_compile(&log_ts, "yyyy-mm-dd hh:mi:ss.ms", 0);
+	}
+	sftimec(ts, sizeof(ts), &log_ts);
+	now = log_ts.sec;
+	len = snprintf(buf, LOG_HEAD_SIZE, "[%s] %s (%s:%d) - ", priorities[level], ts, file, line);
+	if (len < 0) {
+		return;
+	} else if (len >= LOG_HEAD_SIZE) {
+		len = LOG_HEAD_SIZE - 1;
+	}
+	n = vsnprintf(buf + len, LOG_SIZE + 1, format, args);
+	if (n < 0) {
+		n = 0;
+	} else if (n > LOG_SIZE) {
+		n = LOG_SIZE;
+	}
+	len += n;
+	buf[len++] = '\n';
+	if (log_async_put(file_name, now, level, buf, len) == 0) {
+		return;
+	}
+	iov.iov_base = buf;
+	iov.iov_len = len;
+	log_file_write(file_name, &now, &iov, 1);
+}
+
 /**
  * @brief ־ӿڡ
- * 
+ *
  * @param name ־ļơ
  * @param level ־ȼ
  * @param format ־ݸʽ
@@ -23,28 +693,10 @@
  */
 void vLOGN(const char *name, const int level, const char *file, const int line, const char *format, va_list args)
 {
-	FILE *fp;
-	char buf[LOG_SIZE + 1], FilePath[LOG_PATH_MAX + 1], file_name[LOG_NAME_MAX + 1];
-	char ts[50];
-	
-	if (name == NULL) {
-		strcpy(file_name, "log");
-	} else {
-		strcpy(file_name, name);
-	}
-	memset(ts, 0, sizeof(ts));
-	sftime(ts, sizeof(ts), "yyyy-mm-dd");
-	sprintf(FilePath, "%s%s.%s.log", LOG_PATH, file_name, ts);
-	vsprintf(buf, format, args);
-	fp = fopen(FilePath, "a+");
-	if (fp == null) {
+	if (level > log_get_level(name ? name : "log")) {
 		return;
 	}
-	memset(ts, 0, sizeof(ts));
-	sftime(ts, sizeof(ts), "yyyy-mm-dd hh:mi:ss.ms");
-	fprintf(fp, "[%s] %s (%s:%d) - %s\n", priorities[level], ts, file, line, buf);
-	fflush(fp);
-	fclose(fp);
+	log_vwrite(name, level, file, line, format, args);
 }
 
 /**
@@ -64,6 +716,23 @@ void _LOGN(const char *name, const int level, const char *file, const int line,
 	va_end(args);
 }
 
+/**
+ * @brief д־LOG/LOGNڵõжϹȼãٰƲҵȼ
+ * 
+ * @param name ־ļƣΪNULLʱͬ_LOG
+ * @param level ־ȼ
+ * @param format ־ݸʽ
+ * @param ... ʽ
+ */
+void _LOG_SITE(const char *name, const int level, const char *file, const int line, const char *format, ...)
+{
+	va_list args;
+	
+	va_start(args, format);
+	log_vwrite(name, level, file, line, format, args);
+	va_end(args);
+}
+
 /**
  * @brief д־
  * 
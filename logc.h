@@ -11,6 +11,7 @@
 
 #include "types.h"
 #include <stdarg.h>
+#include <sys/types.h>
 
 /** @brief ־ļ· */
 #define LOG_PATH "../logs/"
@@ -20,6 +21,8 @@
 #define LOG_NAME_MAX 50
 /** @brief ־ļ·󳤶 */
 #define LOG_PATH_MAX 256
+/** @brief ͬʱִ򿪵־ļ */
+#define LOG_FILE_CACHE 16
 
 /** @brief ־ȼ(LOG_LEVEL) */
 typedef enum {
@@ -50,12 +53,83 @@ static const char * const priorities[] = {
 	"UNKNOWN"
 };
 
-#define LOG(level, format, ...) _LOG(level, __FILE__, __LINE__, format, ##__VA_ARGS__)
-#define LOGN(name, level, format, ...) _LOGN(name, level, __FILE__, __LINE__, format, ##__VA_ARGS__)
+/** @brief 첽־Ĭ */
+#define LOG_ASYNC_CAPACITY 4096
+/** @brief 첽־ÿ¼ǶС¼з */
+#define LOG_ASYNC_LINE 512
+/** @brief ̵̨߳д¼ */
+#define LOG_ASYNC_BATCH 256
+
+/** @brief 첽־ʱĴ(LOG_OVERFLOW) */
+typedef enum {
+	LOG_OVERFLOW_BLOCK,		/* ȴ̨߳ڳռ */
+	LOG_OVERFLOW_DROP,		/* ¼¼ */
+	LOG_OVERFLOW_DROP_LOW	/* LOG_NOTICE͵ȼļ¼ߵȼȴ */
+}LOG_OVERFLOW;
+
+/** @brief Ƶõȼ־ļ */
+#define LOG_LEVEL_NAMES 32
+
+/**
+ * @brief ־ȼȼֵڸֵLOG/LOGNڱʱȥֵ
+ * -DLOG_COMPILE_LEVEL=LOG_INFOȥȫLOG_DEBUGLOG_TRACE־
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_UNKNOWN
+#endif
+
+/** @brief ־ļڵȼֵlog_set_levelάֻ */
+extern int log_level_max;
+/** @brief ڵȼ±0ΪĬϵȼΪƵõĵȼ±겻䡣ֻ */
+extern int log_level_value[LOG_LEVEL_NAMES + 1];
+/** @brief õʱõ㻺֮ʧЧֻ */
+extern unsigned log_level_gen;
+
+/**
+ * @brief õ㻺(LOG_SITE)LOG/LOGNÿõΪÿ̱߳ƽĵȼ±꣬
+ * ָlog_level_genûʱֱӶԼĵȼƱ
+ * 水ָȽϣͬһָָݸıʱӦvLOGN
+ */
+typedef struct {
+	const char *name;
+	unsigned gen;		/* 0Ϊδ */
+	int slot;			/* log_level_value± */
+}LOG_SITE;
+
+int log_site_resolve(LOG_SITE *site, const char *name);
+
+#define LOG_SITE_SLOT(s, n) \
+	((s)->name == (n) && (s)->gen == __atomic_load_n(&log_level_gen, __ATOMIC_ACQUIRE) \
+		? (s)->slot : log_site_resolve(s, n))
+
+/** @brief жϵȼǷܱһ־ֻȽȫ־ȼֵ */
+#define LOG_ENABLED(level) ((level) <= LOG_COMPILE_LEVEL && (level) <= __atomic_load_n(&log_level_max, __ATOMIC_RELAXED))
+
+/** @brief Լĵȼжϣδͨʱֵʽ */
+#define LOGN(name, level, format, ...) do { \
+	if ((level) <= LOG_COMPILE_LEVEL) { \
+		static __thread LOG_SITE _log_site; \
+		const char *_log_name = (name); \
+		if ((level) <= __atomic_load_n(&log_level_value[LOG_SITE_SLOT(&_log_site, _log_name)], __ATOMIC_RELAXED)) \
+			_LOG_SITE(_log_name, level, __FILE__, __LINE__, format, ##__VA_ARGS__); \
+	} \
+} while (0)
+#define LOG(level, format, ...) LOGN(NULL, level, format, ##__VA_ARGS__)
 
 void vLOGN(const char *name, const int level, const char *file, const int line, const char *format, va_list args);
 void _LOGN(const char *name, const int level, const char *file, const int line, const char *format, ...);
 void _LOG(const int level, const char *file, const int line, const char *format, ...);
+void _LOG_SITE(const char *name, const int level, const char *file, const int line, const char *format, ...);
+
+int log_set_level(const char *name, const int level);
+int log_get_level(const char *name);
+void log_set_max_size(const off_t size);
+void log_close(void);
+
+int log_async_start(const int capacity, const LOG_OVERFLOW policy);
+int log_async_flush(void);
+void log_async_stop(void);
+unsigned long log_async_dropped(void);
 
 #endif /*__LOGC_H__*/
 
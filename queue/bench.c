@@ -0,0 +1,144 @@
+/*
+ * Throughput of MpmcQueue against the mutex-guarded byte ring
+ * (iolock + write_data/read_data), with N producers and N consumers
+ * moving 8-byte records.
+ *
+ *   ./bench [records-per-producer]
+ */
+#include <stdio.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include "queue.h"
+#include "mpmc_queue.h"
+
+#define BENCH_CAPACITY 4096
+#define BENCH_BATCH 32
+
+typedef struct {
+	int mode;
+	long count;
+	long consumed;
+	MpmcQueue mpmc;
+	RingBufferContext ring;
+}Bench;
+
+enum { BENCH_MUTEX, BENCH_MPMC, BENCH_MPMC_BATCH };
+
+static Bench bench;
+
+static void* bench_producer(void* arg)
+{
+	uint64_t rec[BENCH_BATCH];
+	long i = 0;
+	int j, n;
+
+	(void)arg;
+	while(i < bench.count)
+	{
+		if(bench.mode == BENCH_MUTEX)
+		{
+			rec[0] = i;
+			pthread_mutex_lock(&iolock);
+			n = write_data(&bench.ring, (uint8_t*)rec, sizeof(rec[0])) > 0;
+			pthread_mutex_unlock(&iolock);
+		}
+		else if(bench.mode == BENCH_MPMC)
+		{
+			rec[0] = i;
+			n = mpmc_queue_push(&bench.mpmc, rec) == 0;
+		}
+		else
+		{
+			n = bench.count - i < BENCH_BATCH ? bench.count - i : BENCH_BATCH;
+			for(j = 0; j < n; j++)
+				rec[j] = i + j;
+			n = mpmc_queue_push_batch(&bench.mpmc, rec, n);
+		}
+		if(n == 0)
+			sched_yield();
+		i += n;
+	}
+	return NULL;
+}
+
+static void* bench_consumer(void* arg)
+{
+	uint64_t rec[BENCH_BATCH];
+	long total = (long)arg;
+	int n;
+
+	while(__atomic_load_n(&bench.consumed, __ATOMIC_RELAXED) < total)
+	{
+		if(bench.mode == BENCH_MUTEX)
+		{
+			pthread_mutex_lock(&iolock);
+			n = ring_buffer_datasize(&bench.ring) >= (int)sizeof(rec[0])
+				&& ring_buffer_read(&bench.ring, (uint8_t*)rec, sizeof(rec[0])) == 0;
+			pthread_mutex_unlock(&iolock);
+		}
+		else if(bench.mode == BENCH_MPMC)
+		{
+			n = mpmc_queue_pop(&bench.mpmc, rec) == 0;
+		}
+		else
+		{
+			n = mpmc_queue_pop_batch(&bench.mpmc, rec, BENCH_BATCH);
+		}
+		if(n == 0)
+			sched_yield();
+		else
+			__atomic_add_fetch(&bench.consumed, n, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+static double bench_run(int mode, int threads, long count)
+{
+	pthread_t tid[64];
+	struct timespec t0, t1;
+	long total = count * threads;
+	int i;
+
+	bench.mode = mode;
+	bench.count = count;
+	bench.consumed = 0;
+	if(mode == BENCH_MUTEX)
+		ring_buffer_init(&bench.ring, BENCH_CAPACITY * sizeof(uint64_t));
+	else
+		mpmc_queue_init(&bench.mpmc, BENCH_CAPACITY, sizeof(uint64_t));
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < threads; i++)
+	{
+		pthread_create(&tid[2 * i], NULL, bench_producer, NULL);
+		pthread_create(&tid[2 * i + 1], NULL, bench_consumer, (void*)total);
+	}
+	for(i = 0; i < 2 * threads; i++)
+		pthread_join(tid[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	if(mode == BENCH_MUTEX)
+		ring_buffer_free(&bench.ring);
+	else
+		mpmc_queue_free(&bench.mpmc);
+	return total / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9) / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+	static const int threads[] = { 1, 2, 4, 8, 16 };
+	long count = argc > 1 ? atol(argv[1]) : 1000000;
+	int i;
+
+	printf("%-8s %14s %14s %14s  (Mrec/s, %ld records per producer)\n",
+		"threads", "mutex+ring", "mpmc", "mpmc batch", count);
+	for(i = 0; i < (int)(sizeof(threads) / sizeof(threads[0])); i++)
+	{
+		printf("%-8d %14.2f %14.2f %14.2f\n", threads[i],
+			bench_run(BENCH_MUTEX, threads[i], count),
+			bench_run(BENCH_MPMC, threads[i], count),
+			bench_run(BENCH_MPMC_BATCH, threads[i], count));
+	}
+	return 0;
+}
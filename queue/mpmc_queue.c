@@ -0,0 +1,133 @@
+#include <errno.h>
+#include "mpmc_queue.h"
+
+#define MPMC_SEQ(q, pos) ((size_t*)((q)->cells + ((pos) & (q)->mask) * (q)->cell_size))
+#define MPMC_DATA(q, pos) ((uint8_t*)MPMC_SEQ(q, pos) + sizeof(size_t))
+
+/* capacity is rounded up to a power of two */
+int mpmc_queue_init(MpmcQueue* q, int capacity, int elem_size)
+{
+	size_t i, size = 2;
+
+	q->cells = NULL;
+	if(capacity <= 0 || elem_size <= 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	while(size < (size_t)capacity)
+		size <<= 1;
+	q->elem_size = elem_size;
+	q->cell_size = (sizeof(size_t) + elem_size + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+	if(posix_memalign((void**)&q->cells, RING_BUFFER_CACHELINE, size * q->cell_size) != 0)
+	{
+		q->cells = NULL;
+		errno = ENOMEM;
+		return -1;
+	}
+	q->mask = size - 1;
+	for(i = 0; i < size; i++)
+		*MPMC_SEQ(q, i) = i;
+	q->enqueue_pos = 0;
+	q->dequeue_pos = 0;
+	return 0;
+}
+
+void mpmc_queue_free(MpmcQueue* q)
+{
+	free(q->cells);
+	q->cells = NULL;
+}
+
+int mpmc_queue_capacity(MpmcQueue* q)
+{
+	return (int)(q->mask + 1);
+}
+
+/* returns 0, or -1 when the queue is full */
+int mpmc_queue_push(MpmcQueue* q, const void* elem)
+{
+	return mpmc_queue_push_batch(q, elem, 1) == 1 ? 0 : -1;
+}
+
+/* returns 0, or -1 when the queue is empty */
+int mpmc_queue_pop(MpmcQueue* q, void* elem)
+{
+	return mpmc_queue_pop_batch(q, elem, 1) == 1 ? 0 : -1;
+}
+
+/*
+ * Claim up to count consecutive free slots with a single CAS, fill them
+ * and publish each one. Returns the number of records pushed, 0 when full.
+ */
+int mpmc_queue_push_batch(MpmcQueue* q, const void* elems, int count)
+{
+	size_t pos, seq;
+	int i, n;
+
+	pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+	for(;;)
+	{
+		for(n = 0; n < count; n++)
+		{
+			seq = __atomic_load_n(MPMC_SEQ(q, pos + n), __ATOMIC_ACQUIRE);
+			if(seq != pos + n)
+				break;
+		}
+		if(n == 0)
+		{
+			seq = __atomic_load_n(MPMC_SEQ(q, pos), __ATOMIC_ACQUIRE);
+			if((intptr_t)(seq - pos) < 0)
+				return 0;
+			//another producer took the slot, retry from the new position
+			pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+			continue;
+		}
+		if(__atomic_compare_exchange_n(&q->enqueue_pos, &pos, pos + n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+	for(i = 0; i < n; i++)
+	{
+		memcpy(MPMC_DATA(q, pos + i), (const uint8_t*)elems + i * q->elem_size, q->elem_size);
+		__atomic_store_n(MPMC_SEQ(q, pos + i), pos + i + 1, __ATOMIC_RELEASE);
+	}
+	return n;
+}
+
+/*
+ * Claim up to count consecutive filled slots with a single CAS, copy them
+ * out and hand the slots back. Returns the number of records popped, 0
+ * when empty.
+ */
+int mpmc_queue_pop_batch(MpmcQueue* q, void* elems, int count)
+{
+	size_t pos, seq;
+	int i, n;
+
+	pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+	for(;;)
+	{
+		for(n = 0; n < count; n++)
+		{
+			seq = __atomic_load_n(MPMC_SEQ(q, pos + n), __ATOMIC_ACQUIRE);
+			if(seq != pos + n + 1)
+				break;
+		}
+		if(n == 0)
+		{
+			seq = __atomic_load_n(MPMC_SEQ(q, pos), __ATOMIC_ACQUIRE);
+			if((intptr_t)(seq - (pos + 1)) < 0)
+				return 0;
+			pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+			continue;
+		}
+		if(__atomic_compare_exchange_n(&q->dequeue_pos, &pos, pos + n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+	for(i = 0; i < n; i++)
+	{
+		memcpy((uint8_t*)elems + i * q->elem_size, MPMC_DATA(q, pos + i), q->elem_size);
+		__atomic_store_n(MPMC_SEQ(q, pos + i), pos + i + q->mask + 1, __ATOMIC_RELEASE);
+	}
+	return n;
+}
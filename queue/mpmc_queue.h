@@ -0,0 +1,31 @@
+#ifndef MPMC_QUEUE_H_
+#define MPMC_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "queue.h"
+
+/*
+ * Bounded multi-producer/multi-consumer queue of fixed-size records
+ * (Vyukov). Every slot carries a sequence number that tells producers
+ * and consumers whether it is free or filled for a given lap, so threads
+ * only contend on one CAS of enqueue_pos or dequeue_pos.
+ */
+typedef struct {
+	uint8_t* cells;
+	size_t cell_size;
+	size_t elem_size;
+	size_t mask;
+	size_t enqueue_pos __attribute__((aligned(RING_BUFFER_CACHELINE)));
+	size_t dequeue_pos __attribute__((aligned(RING_BUFFER_CACHELINE)));
+}MpmcQueue;
+
+int mpmc_queue_init(MpmcQueue* q, int capacity, int elem_size);
+void mpmc_queue_free(MpmcQueue* q);
+int mpmc_queue_push(MpmcQueue* q, const void* elem);
+int mpmc_queue_pop(MpmcQueue* q, void* elem);
+int mpmc_queue_push_batch(MpmcQueue* q, const void* elems, int count);
+int mpmc_queue_pop_batch(MpmcQueue* q, void* elems, int count);
+int mpmc_queue_capacity(MpmcQueue* q);
+
+#endif //MPMC_QUEUE_H_
@@ -1,10 +1,284 @@
+#define _GNU_SOURCE
 #include <queue.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+pthread_mutex_t iolock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Single-producer/single-consumer without locks: ring_buffer_write and
+ * write_data may only be called from one thread, ring_buffer_read and
+ * read_data from one other thread. Data is published with a release
+ * store of tail and handed back with a release store of head.
+ */
+
+static inline uint32_t ring_buffer_offset(RingBufferContext* ctx, uint32_t pos)
+{
+	return pos >= (uint32_t)ctx->buffer_size ? pos - ctx->buffer_size : pos;
+}
+
+static inline uint32_t ring_buffer_advance(RingBufferContext* ctx, uint32_t pos, int size)
+{
+	pos += size;
+	return pos >= 2 * (uint32_t)ctx->buffer_size ? pos - 2 * ctx->buffer_size : pos;
+}
+
+static inline int ring_buffer_distance(RingBufferContext* ctx, uint32_t head, uint32_t tail)
+{
+	int used = (int)tail - (int)head;
+	return used < 0 ? used + 2 * ctx->buffer_size : used;
+}
+
+/* bytes the producer may write; reloads head only when the cached copy is short */
+static int ring_buffer_space(RingBufferContext* ctx, int want)
+{
+	RingBufferIndex* idx = ctx->index;
+	uint32_t tail = idx->tail;
+	int space = ctx->buffer_size - ring_buffer_distance(ctx, idx->head_cache, tail);
+
+	if(space < want)
+	{
+		idx->head_cache = __atomic_load_n(&idx->head, __ATOMIC_ACQUIRE);
+		space = ctx->buffer_size - ring_buffer_distance(ctx, idx->head_cache, tail);
+	}
+	return space;
+}
+
+/* bytes the consumer may read; reloads tail only when the cached copy is short */
+static int ring_buffer_avail(RingBufferContext* ctx, int want)
+{
+	RingBufferIndex* idx = ctx->index;
+	uint32_t head = idx->head;
+	int avail = ring_buffer_distance(ctx, head, idx->tail_cache);
+
+	if(avail < want)
+	{
+		idx->tail_cache = __atomic_load_n(&idx->tail, __ATOMIC_ACQUIRE);
+		avail = ring_buffer_distance(ctx, head, idx->tail_cache);
+	}
+	return avail;
+}
+
+/*
+ * Blocking waits sleep on a futex event word instead of polling. The
+ * sleeper publishes how many bytes it needs in read_want/write_want; the
+ * other side only issues FUTEX_WAKE once that much is available, so a
+ * reader waiting for a large chunk is not woken by every small write.
+ * The futexes are not FUTEX_PRIVATE so they also work on shared mappings.
+ * A reader waiting for r bytes and a writer waiting for w bytes can only
+ * both sleep if r + w > buffer_size + 1, so size the ring accordingly.
+ */
+static int ring_buffer_futex_wait(uint32_t* addr, uint32_t val, struct timespec* deadline)
+{
+	struct timespec now, rel, *timeout = NULL;
+
+	if(deadline)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		rel.tv_sec = deadline->tv_sec - now.tv_sec;
+		rel.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+		if(rel.tv_nsec < 0)
+		{
+			rel.tv_sec--;
+			rel.tv_nsec += 1000000000L;
+		}
+		if(rel.tv_sec < 0)
+		{
+			errno = ETIMEDOUT;
+			return -1;
+		}
+		timeout = &rel;
+	}
+	if(syscall(SYS_futex, addr, FUTEX_WAIT, val, timeout, NULL, 0) == -1 && errno == ETIMEDOUT)
+		return -1;
+	return 0;
+}
+
+static void ring_buffer_futex_wake(uint32_t* event)
+{
+	__atomic_add_fetch(event, 1, __ATOMIC_SEQ_CST);
+	syscall(SYS_futex, event, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static struct timespec* ring_buffer_deadline(struct timespec* ts, int timeout_ms)
+{
+	if(timeout_ms < 0)
+		return NULL;
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += timeout_ms / 1000;
+	ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+	if(ts->tv_nsec >= 1000000000L)
+	{
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+	return ts;
+}
+
+/* called by the producer after publishing tail */
+static void ring_buffer_wake_reader(RingBufferContext* ctx)
+{
+	RingBufferIndex* idx = ctx->index;
+	uint32_t want;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	want = __atomic_load_n(&idx->read_want, __ATOMIC_RELAXED);
+	if(want && ring_buffer_distance(ctx, __atomic_load_n(&idx->head, __ATOMIC_ACQUIRE), idx->tail) >= (int)want
+		&& __atomic_compare_exchange_n(&idx->read_want, &want, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+	{
+		ring_buffer_futex_wake(&idx->read_event);
+	}
+}
+
+/* called by the consumer after publishing head */
+static void ring_buffer_wake_writer(RingBufferContext* ctx)
+{
+	RingBufferIndex* idx = ctx->index;
+	uint32_t want;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	want = __atomic_load_n(&idx->write_want, __ATOMIC_RELAXED);
+	if(want && ctx->buffer_size - ring_buffer_distance(ctx, idx->head, __atomic_load_n(&idx->tail, __ATOMIC_ACQUIRE)) >= (int)want
+		&& __atomic_compare_exchange_n(&idx->write_want, &want, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+	{
+		ring_buffer_futex_wake(&idx->write_event);
+	}
+}
+
+/*
+ * Consumer side: block until at least size bytes are buffered or the ring
+ * is closed. Returns the bytes available (less than size only after
+ * close, 0 meaning EOF), or -1 with errno ETIMEDOUT/EINVAL.
+ */
+int ring_buffer_wait_data(RingBufferContext* ctx, int size, int timeout_ms)
+{
+	RingBufferIndex* idx = ctx->index;
+	struct timespec ts, *deadline = ring_buffer_deadline(&ts, timeout_ms);
+	uint32_t event;
+	int avail;
+
+	if(size <= 0 || size > ctx->buffer_size)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	for(;;)
+	{
+		if((avail = ring_buffer_avail(ctx, size)) >= size)
+			return avail;
+		if(__atomic_load_n(&idx->closed, __ATOMIC_ACQUIRE))
+			return ring_buffer_avail(ctx, size);
+		event = __atomic_load_n(&idx->read_event, __ATOMIC_ACQUIRE);
+		__atomic_store_n(&idx->read_want, size, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(ring_buffer_avail(ctx, size) < size && !__atomic_load_n(&idx->closed, __ATOMIC_SEQ_CST)
+			&& ring_buffer_futex_wait(&idx->read_event, event, deadline) == -1)
+		{
+			__atomic_store_n(&idx->read_want, 0, __ATOMIC_RELAXED);
+			return -1;
+		}
+		__atomic_store_n(&idx->read_want, 0, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * Producer side: block until at least size bytes are free. Returns the
+ * free space, or -1 with errno EPIPE once the ring is closed, ETIMEDOUT
+ * or EINVAL.
+ */
+int ring_buffer_wait_space(RingBufferContext* ctx, int size, int timeout_ms)
+{
+	RingBufferIndex* idx = ctx->index;
+	struct timespec ts, *deadline = ring_buffer_deadline(&ts, timeout_ms);
+	uint32_t event;
+	int space;
+
+	if(size <= 0 || size > ctx->buffer_size)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	for(;;)
+	{
+		if(__atomic_load_n(&idx->closed, __ATOMIC_ACQUIRE))
+		{
+			errno = EPIPE;
+			return -1;
+		}
+		if((space = ring_buffer_space(ctx, size)) >= size)
+			return space;
+		event = __atomic_load_n(&idx->write_event, __ATOMIC_ACQUIRE);
+		__atomic_store_n(&idx->write_want, size, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(ring_buffer_space(ctx, size) < size && !__atomic_load_n(&idx->closed, __ATOMIC_SEQ_CST)
+			&& ring_buffer_futex_wait(&idx->write_event, event, deadline) == -1)
+		{
+			__atomic_store_n(&idx->write_want, 0, __ATOMIC_RELAXED);
+			return -1;
+		}
+		__atomic_store_n(&idx->write_want, 0, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * Read exactly size bytes, sleeping until they are available. After
+ * ring_buffer_close the remaining bytes are returned, then 0 for EOF.
+ * timeout_ms < 0 waits forever.
+ */
+int ring_buffer_read_wait(RingBufferContext* ctx, uint8_t* buffer, int size, int timeout_ms)
+{
+	int avail = ring_buffer_wait_data(ctx, size, timeout_ms);
+
+	if(avail <= 0)
+		return avail;
+	if(avail > size)
+		avail = size;
+	if(ring_buffer_read(ctx, buffer, avail) != 0)
+		return -1;
+	return avail;
+}
+
+/*
+ * Write all size bytes, sleeping until there is room. Fails with EPIPE
+ * once the ring is closed.
+ */
+int ring_buffer_write_wait(RingBufferContext* ctx, uint8_t* buffer, int size, int timeout_ms)
+{
+	if(ring_buffer_wait_space(ctx, size, timeout_ms) < 0)
+		return -1;
+	if(ring_buffer_write(ctx, buffer, size) != 0)
+		return -1;
+	return size;
+}
+
+/*
+ * Mark end of stream (or abort, when called by the consumer) and wake
+ * both sides. Buffered data can still be read.
+ */
+void ring_buffer_close(RingBufferContext* ctx)
+{
+	RingBufferIndex* idx = ctx->index;
+
+	__atomic_store_n(&idx->closed, 1, __ATOMIC_SEQ_CST);
+	ring_buffer_futex_wake(&idx->read_event);
+	ring_buffer_futex_wake(&idx->write_event);
+}
+
+int ring_buffer_closed(RingBufferContext* ctx)
+{
+	return __atomic_load_n(&ctx->index->closed, __ATOMIC_ACQUIRE);
+}
 
 int read_data(RingBufferContext* ctx, uint8_t* buffer, int buf_size)
 {
-	int ret = 0, datasize = 0, size = 0;
-	datasize = ring_buffer_datasize(ctx);
-	size = datasize;
+	int size = ring_buffer_avail(ctx, buf_size);
 	
 	if(size <= 0)
 		return 0;
@@ -13,20 +287,15 @@ int read_data(RingBufferContext* ctx, uint8_t* buffer, int buf_size)
 		size = buf_size;
 	}
 	
-	ret = ring_buffer_read(ctx, buffer, size);
-	if(ret == 0)
-		ret = size;
+	if(ring_buffer_read(ctx, buffer, size) == 0)
+		return size;
 	else
-		ret =0;
-	
-	return ret;
+		return 0;
 }
 
 int write_data(RingBufferContext* ctx, uint8_t* buffer, int buf_size)
 {
-	int ret = 0;
-	int freesize = ring_buffer_freesize(ctx);
-	int size = freesize;
+	int size = ring_buffer_space(ctx, buf_size);
 	
 	if(size <= 0)
 		return 0;
@@ -34,111 +303,526 @@ int write_data(RingBufferContext* ctx, uint8_t* buffer, int buf_size)
 		size = buf_size;
 	else //freesize < buf_size
 	{
-		//size = freesize;
 		return -1;
 	}
-	ret = ring_buffer_write(ctx, buffer, size);
-	if(0 == ret)
-		ret = size;
+	if(ring_buffer_write(ctx, buffer, size) == 0)
+		return size;
 	else
-		ret = 0;
-	
-	return ret;
+		return 0;
+}
+
+/* describe size bytes starting at pos as one span, or two at the wrap point */
+static void ring_buffer_spans(RingBufferContext* ctx, uint32_t pos, int size, struct iovec iov[2])
+{
+	uint8_t* ptr = ctx->buffer_base + ring_buffer_offset(ctx, pos);
+
+	iov[0].iov_base = ptr;
+	if(ctx->mode == RING_BUFFER_MIRROR || ctx->mode == RING_BUFFER_SHM)
+	{
+		//the second mapping continues where buffer_end stops
+		iov[0].iov_len = size;
+		iov[1].iov_base = ctx->buffer_base;
+		iov[1].iov_len = 0;
+	}
+	else if((ptr + size) > ctx->buffer_end)
+	{
+		iov[0].iov_len = ctx->buffer_end - ptr;
+		iov[1].iov_base = ctx->buffer_base;
+		iov[1].iov_len = size - iov[0].iov_len;
+	}
+	else
+	{
+		iov[0].iov_len = size;
+		iov[1].iov_base = ctx->buffer_base;
+		iov[1].iov_len = 0;
+	}
+}
+
+/*
+ * Zero-copy producer side: hand out all free space as up to two spans
+ * (iov[1].iov_len is 0 when it is contiguous) that can be filled in place,
+ * e.g. with readv(), then published with ring_buffer_commit(). Returns
+ * the free bytes.
+ */
+int ring_buffer_reserve(RingBufferContext* ctx, struct iovec iov[2])
+{
+	int space = ring_buffer_space(ctx, ctx->buffer_size);
+
+	ring_buffer_spans(ctx, ctx->index->tail, space, iov);
+	return space;
+}
+
+int ring_buffer_commit(RingBufferContext* ctx, int size)
+{
+	RingBufferIndex* idx = ctx->index;
+
+	if(size < 0 || size > ring_buffer_space(ctx, size))
+		return -1;
+	__atomic_store_n(&idx->tail, ring_buffer_advance(ctx, idx->tail, size), __ATOMIC_RELEASE);
+	ring_buffer_wake_reader(ctx);
+	return 0;
+}
+
+/*
+ * Zero-copy consumer side: expose all buffered data as up to two spans,
+ * e.g. for writev(), then release what was used with ring_buffer_consume().
+ * Returns the buffered bytes.
+ */
+int ring_buffer_peek(RingBufferContext* ctx, struct iovec iov[2])
+{
+	int avail = ring_buffer_avail(ctx, ctx->buffer_size);
+
+	ring_buffer_spans(ctx, ctx->index->head, avail, iov);
+	return avail;
+}
+
+int ring_buffer_consume(RingBufferContext* ctx, int size)
+{
+	RingBufferIndex* idx = ctx->index;
+
+	if(size < 0 || size > ring_buffer_avail(ctx, size))
+		return -1;
+	__atomic_store_n(&idx->head, ring_buffer_advance(ctx, idx->head, size), __ATOMIC_RELEASE);
+	ring_buffer_wake_writer(ctx);
+	return 0;
 }
 
 int ring_buffer_write(RingBufferContext* ctx, uint8_t* buffer, int size)
 {
-	uint8_t* wptr = ctx->data_ptr + ctx->data_size;
-	uint8_t* wptr2 = NULL;
-	int size2 = 0;
-	if(size <= (ctx->buffer_size - ctx->data_size))//space available
+	struct iovec iov[2];
+
+	if(size > ring_buffer_space(ctx, size))
+		return -1;
+
+	ring_buffer_spans(ctx, ctx->index->tail, size, iov);
+	memcpy(iov[0].iov_base, buffer, iov[0].iov_len);
+	memcpy(iov[1].iov_base, buffer + iov[0].iov_len, iov[1].iov_len);
+	return ring_buffer_commit(ctx, size);
+}
+
+int ring_buffer_read(RingBufferContext* ctx, uint8_t* buffer, int size)
+{
+	struct iovec iov[2];
+
+	if(size > ring_buffer_avail(ctx, size))
+		return -1;
+
+	ring_buffer_spans(ctx, ctx->index->head, size, iov);
+	memcpy(buffer, iov[0].iov_base, iov[0].iov_len);
+	memcpy(buffer + iov[0].iov_len, iov[1].iov_base, iov[1].iov_len);
+	return ring_buffer_consume(ctx, size);
+}
+
+/*
+ * Record mode. A record is written with a single commit of header and
+ * payload, so a consumer that sees the header always sees the whole
+ * record. Record and byte-stream calls must not be mixed on one ring.
+ */
+static void ring_buffer_copy_in(struct iovec iov[2], int off, const uint8_t* src, int size)
+{
+	int n;
+
+	if(off < (int)iov[0].iov_len)
 	{
-		if(wptr >= ctx->buffer_end)//rrrrrwwwwwwrrrrrr
-		{
-			int skip = wptr - ctx->buffer_end;
-			wptr = ctx->buffer_base + skip;
-		}
-		else if((wptr + size) > ctx->buffer_end)//wwwwwrrrrrrww
-		{
-			wptr2 = ctx->buffer_base;
-			size2 = size - (ctx->buffer_end - wptr);
-			size -= size2;
-		}
-		else//rrrrwwwww
-		{
-			//nothing
-		}
-		memcpy(wptr, buffer, size);
-		if(wptr2)
-		{
-			memcpy(wptr2, buffer+size, size2);
-		}
-		ctx->data_size += (size+size2);
-		return 0;
+		n = (int)iov[0].iov_len - off < size ? (int)iov[0].iov_len - off : size;
+		memcpy((uint8_t*)iov[0].iov_base + off, src, n);
+		src += n;
+		size -= n;
+		off = 0;
+	}
+	else
+	{
+		off -= iov[0].iov_len;
+	}
+	memcpy((uint8_t*)iov[1].iov_base + off, src, size);
+}
+
+static void ring_buffer_copy_out(struct iovec iov[2], int off, uint8_t* dst, int size)
+{
+	int n;
+
+	if(off < (int)iov[0].iov_len)
+	{
+		n = (int)iov[0].iov_len - off < size ? (int)iov[0].iov_len - off : size;
+		memcpy(dst, (uint8_t*)iov[0].iov_base + off, n);
+		dst += n;
+		size -= n;
+		off = 0;
 	}
 	else
 	{
+		off -= iov[0].iov_len;
+	}
+	memcpy(dst, (uint8_t*)iov[1].iov_base + off, size);
+}
+
+/* payload length of the record at pos, or -1 if fewer than avail bytes hold no header */
+static int ring_buffer_record_len(RingBufferContext* ctx, uint32_t pos, int avail)
+{
+	struct iovec iov[2];
+	uint32_t len;
+
+	if(avail < RING_BUFFER_RECORD_HEADER)
+		return -1;
+	ring_buffer_spans(ctx, pos, RING_BUFFER_RECORD_HEADER, iov);
+	ring_buffer_copy_out(iov, 0, (uint8_t*)&len, RING_BUFFER_RECORD_HEADER);
+	return (int)len;
+}
+
+/* returns 0, or -1 with errno EAGAIN when full, EMSGSIZE when it can never fit */
+int ring_buffer_write_record(RingBufferContext* ctx, const uint8_t* data, int size)
+{
+	struct iovec iov[2];
+	uint32_t len = size;
+	int total = RING_BUFFER_RECORD_HEADER + size;
+
+	if(size < 0 || total > ctx->buffer_size)
+	{
+		errno = EMSGSIZE;
 		return -1;
 	}
+	if(total > ring_buffer_space(ctx, total))
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	ring_buffer_spans(ctx, ctx->index->tail, total, iov);
+	ring_buffer_copy_in(iov, 0, (const uint8_t*)&len, RING_BUFFER_RECORD_HEADER);
+	ring_buffer_copy_in(iov, RING_BUFFER_RECORD_HEADER, data, size);
+	return ring_buffer_commit(ctx, total);
 }
 
-int ring_buffer_read(RingBufferContext* ctx, uint8_t* buffer, int size)
+int ring_buffer_write_record_wait(RingBufferContext* ctx, const uint8_t* data, int size, int timeout_ms)
 {
-	uint8_t* rptr = ctx->data_ptr + size;
-	uint8_t* rptr2 = ctx->data_ptr + ctx->data_size;
-	int data_size = ctx->data_size;
-	if(size <= ctx->data_size)
+	if(size < 0 || RING_BUFFER_RECORD_HEADER + size > ctx->buffer_size)
 	{
-		if(rptr > ctx->buffer_end)
-		{
-			int size0 = ctx->buffer_end - ctx->data_ptr;
-			int size1 = rptr - ctx->buffer_end;
-			memcpy(buffer, ctx->data_ptr, size0);
-			memcpy(buffer+size0, ctx->buffer_base, size1);
-			ctx->data_ptr = ctx->buffer_base + size1;
-			ctx->data_size -= size;
-		}
-		else
+		errno = EMSGSIZE;
+		return -1;
+	}
+	if(ring_buffer_wait_space(ctx, RING_BUFFER_RECORD_HEADER + size, timeout_ms) < 0)
+		return -1;
+	return ring_buffer_write_record(ctx, data, size);
+}
+
+/*
+ * Expose the payload of the next record in place (two spans if it wraps,
+ * always one in RING_BUFFER_MIRROR mode). Returns its length, or -1 with
+ * errno EAGAIN when no record is buffered. Release it with
+ * ring_buffer_consume_record().
+ */
+int ring_buffer_peek_record(RingBufferContext* ctx, struct iovec iov[2])
+{
+	uint32_t head = ctx->index->head;
+	int len = ring_buffer_record_len(ctx, head, ring_buffer_avail(ctx, RING_BUFFER_RECORD_HEADER));
+
+	if(len < 0)
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	ring_buffer_spans(ctx, ring_buffer_advance(ctx, head, RING_BUFFER_RECORD_HEADER), len, iov);
+	return len;
+}
+
+int ring_buffer_consume_record(RingBufferContext* ctx)
+{
+	int len = ring_buffer_record_len(ctx, ctx->index->head, ring_buffer_avail(ctx, RING_BUFFER_RECORD_HEADER));
+
+	if(len < 0)
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	return ring_buffer_consume(ctx, RING_BUFFER_RECORD_HEADER + len);
+}
+
+/*
+ * Copy the next record out. Returns its length, or -1 with errno EAGAIN
+ * when none is buffered, EMSGSIZE when buffer is too small (the record
+ * stays in the ring).
+ */
+int ring_buffer_read_record(RingBufferContext* ctx, uint8_t* buffer, int size)
+{
+	int lens[1];
+
+	if(ring_buffer_read_records(ctx, buffer, size, lens, 1) == 1)
+		return lens[0];
+	return -1;
+}
+
+/* like ring_buffer_read_record, but sleeps for a record; 0 with errno 0 means EOF */
+int ring_buffer_read_record_wait(RingBufferContext* ctx, uint8_t* buffer, int size, int timeout_ms)
+{
+	int avail = ring_buffer_wait_data(ctx, RING_BUFFER_RECORD_HEADER, timeout_ms);
+
+	if(avail < 0)
+		return -1;
+	if(avail < RING_BUFFER_RECORD_HEADER)
+	{
+		errno = 0;
+		return 0;
+	}
+	return ring_buffer_read_record(ctx, buffer, size);
+}
+
+/*
+ * Copy as many whole records as fit into buffer, back to back, storing
+ * each length in lens[], and release them with a single head update.
+ * Returns the number of records, or -1 with errno EAGAIN/EMSGSIZE when
+ * not even the first one could be read.
+ */
+int ring_buffer_read_records(RingBufferContext* ctx, uint8_t* buffer, int size, int* lens, int max_records)
+{
+	struct iovec iov[2];
+	uint32_t pos = ctx->index->head;
+	int avail = ring_buffer_avail(ctx, ctx->buffer_size);
+	int used = 0, copied = 0, count = 0, len;
+
+	while(count < max_records)
+	{
+		len = ring_buffer_record_len(ctx, pos, avail - used);
+		if(len < 0)
+			break;
+		if(copied + len > size)
 		{
-			memcpy(buffer, ctx->data_ptr, size);
-			ctx->data_ptr = ctx->data_ptr + size;
-			ctx->data_size -= size;
-			if(ctx->data_ptr >= ctx->buffer_end)
+			if(count == 0)
 			{
-				ctx->data_ptr = ctx->buffer_base;
+				errno = EMSGSIZE;
+				return -1;
 			}
+			break;
 		}
-		return 0;
+		ring_buffer_spans(ctx, ring_buffer_advance(ctx, pos, RING_BUFFER_RECORD_HEADER), len, iov);
+		ring_buffer_copy_out(iov, 0, buffer + copied, len);
+		lens[count++] = len;
+		copied += len;
+		used += RING_BUFFER_RECORD_HEADER + len;
+		pos = ring_buffer_advance(ctx, pos, RING_BUFFER_RECORD_HEADER + len);
 	}
-	else
+	if(count == 0)
 	{
+		errno = EAGAIN;
 		return -1;
 	}
+	ring_buffer_consume(ctx, used);
+	return count;
 }
 
 int ring_buffer_init(RingBufferContext* ctx, int size)
 {
-	ctx->buffer_base = (uint8_t*)malloc(size);
+	return ring_buffer_init_mode(ctx, size, RING_BUFFER_MALLOC);
+}
+
+/*
+ * Map one memfd of size bytes twice, back-to-back, so that any span of up
+ * to size bytes starting inside the first copy is contiguous in memory.
+ */
+static uint8_t* ring_buffer_map_mirror(int size)
+{
+	uint8_t* base;
+	int fd;
+
+	if((fd = memfd_create("ring_buffer", MFD_CLOEXEC)) == -1)
+		return NULL;
+	if(ftruncate(fd, size) == -1)
+	{
+		close(fd);
+		return NULL;
+	}
+	base = (uint8_t*)mmap(NULL, 2 * (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+	if(mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+		|| mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+	{
+		munmap(base, 2 * (size_t)size);
+		close(fd);
+		return NULL;
+	}
+	close(fd);
+	return base;
+}
+
+/*
+ * RING_BUFFER_MIRROR rounds size up to a multiple of the page size; check
+ * ring_buffer_buffersize() for the actual capacity.
+ */
+int ring_buffer_init_mode(RingBufferContext* ctx, int size, int mode)
+{
+	void* index = NULL;
+	long page;
+
+	ctx->buffer_base = NULL;
+	ctx->index = NULL;
+	if(size <= 0 || posix_memalign(&index, RING_BUFFER_CACHELINE, sizeof(RingBufferIndex)) != 0)
+		return -1;
+	if(mode == RING_BUFFER_MIRROR)
+	{
+		page = sysconf(_SC_PAGESIZE);
+		size = (size + page - 1) / page * page;
+		ctx->buffer_base = ring_buffer_map_mirror(size);
+	}
+	else
+	{
+		mode = RING_BUFFER_MALLOC;
+		ctx->buffer_base = (uint8_t*)malloc(size);
+		if(ctx->buffer_base)
+			memset(ctx->buffer_base, 0, size);
+	}
 	if(ctx->buffer_base)
 	{
-		memset(ctx->buffer_base, 0, size);
+		memset(index, 0, sizeof(RingBufferIndex));
 		ctx->buffer_end = ctx->buffer_base + size;
 		ctx->buffer_size = size;
-		ctx->data_ptr = ctx->buffer_base;
-		ctx->data_size = 0;
+		ctx->mode = mode;
+		ctx->index = (RingBufferIndex*)index;
+	}
+	else
+	{
+		free(index);
 	}
 	return ctx->buffer_base ? 0 : -1;
 }
 
+#define RING_BUFFER_SHM_MAGIC 0x52494e47
+
+/*
+ * Create (oflag has O_CREAT, optionally O_EXCL) or attach to the ring
+ * called name in POSIX shared memory, e.g. "/feed". The data area is
+ * rounded up to whole pages and mirrored like RING_BUFFER_MIRROR, so
+ * peeks and reservations are always one span. One producer process and
+ * one consumer process may then use every read/write call on it, with
+ * the futex waits and ring_buffer_close() working across processes.
+ * Attaching ignores size; it fails with EAGAIN while the creator has not
+ * finished initialising the header. Release with ring_buffer_free() and
+ * remove the name with ring_buffer_shm_unlink().
+ */
+int ring_buffer_shm_open(RingBufferContext* ctx, const char* name, int size, int oflag)
+{
+	RingBufferShmHeader* hdr;
+	struct stat st;
+	uint8_t* base = MAP_FAILED;
+	long page = sysconf(_SC_PAGESIZE);
+	int fd, created = 0, ready;
+
+	ctx->buffer_base = NULL;
+	ctx->index = NULL;
+	if(sizeof(RingBufferShmHeader) > (size_t)page)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	fd = -1;
+	if(oflag & O_CREAT)
+	{
+		if(size <= 0 || size > INT_MAX / 2 - page)
+		{
+			errno = EINVAL;
+			return -1;
+		}
+		size = (size + page - 1) / page * page;
+		fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if(fd == -1 && (errno != EEXIST || (oflag & O_EXCL)))
+			return -1;
+		created = fd != -1;
+	}
+	if(fd == -1 && (fd = shm_open(name, O_RDWR, 0)) == -1)
+		return -1;
+
+	if(created)
+	{
+		if(ftruncate(fd, page + size) == -1)
+			goto ERR;
+	}
+	else
+	{
+		/* read the size the creator chose from its header */
+		if(fstat(fd, &st) == -1)
+			goto ERR;
+		if(st.st_size < page)
+		{
+			errno = EAGAIN;
+			goto ERR;
+		}
+		hdr = (RingBufferShmHeader*)mmap(NULL, page, PROT_READ, MAP_SHARED, fd, 0);
+		if(hdr == MAP_FAILED)
+			goto ERR;
+		ready = __atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) == RING_BUFFER_SHM_MAGIC;
+		size = hdr->size;
+		munmap(hdr, page);
+		if(!ready || st.st_size < page + size)
+		{
+			errno = EAGAIN;
+			goto ERR;
+		}
+	}
+
+	/* header page and data, then the data again right behind it */
+	base = (uint8_t*)mmap(NULL, page + 2 * (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+		goto ERR;
+	if(mmap(base, page + size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+		|| mmap(base + page + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, page) == MAP_FAILED)
+		goto ERR;
+	close(fd);
+
+	hdr = (RingBufferShmHeader*)base;
+	if(created)
+	{
+		hdr->size = size;
+		hdr->data_offset = page;
+		__atomic_store_n(&hdr->magic, RING_BUFFER_SHM_MAGIC, __ATOMIC_RELEASE);
+	}
+	ctx->buffer_base = base + hdr->data_offset;
+	ctx->buffer_end = ctx->buffer_base + size;
+	ctx->buffer_size = size;
+	ctx->mode = RING_BUFFER_SHM;
+	ctx->index = &hdr->index;
+	return 0;
+
+ERR:
+	if(base != MAP_FAILED)
+		munmap(base, page + 2 * (size_t)size);
+	close(fd);
+	if(created)
+		shm_unlink(name);
+	return -1;
+}
+
+int ring_buffer_shm_unlink(const char* name)
+{
+	return shm_unlink(name);
+}
+
 void ring_buffer_free(RingBufferContext* ctx)
 {
-	free(ctx->buffer_base);
+	long page;
+
+	if(ctx->mode == RING_BUFFER_SHM && ctx->buffer_base)
+	{
+		page = sysconf(_SC_PAGESIZE);
+		munmap(ctx->buffer_base - page, page + 2 * (size_t)ctx->buffer_size);
+		ctx->buffer_base = NULL;
+		ctx->index = NULL;
+		return;
+	}
+	if(ctx->mode == RING_BUFFER_MIRROR && ctx->buffer_base)
+		munmap(ctx->buffer_base, 2 * (size_t)ctx->buffer_size);
+	else
+		free(ctx->buffer_base);
+	free(ctx->index);
 	ctx->buffer_base = NULL;
+	ctx->index = NULL;
 }
 
 int ring_buffer_datasize(RingBufferContext* ctx)
 {
-	return ctx->data_size;
+	RingBufferIndex* idx = ctx->index;
+	return ring_buffer_distance(ctx, __atomic_load_n(&idx->head, __ATOMIC_ACQUIRE),
+		__atomic_load_n(&idx->tail, __ATOMIC_ACQUIRE));
 }
 
 int ring_buffer_buffersize(RingBufferContext* ctx)
@@ -148,6 +832,6 @@ int ring_buffer_buffersize(RingBufferContext* ctx)
 
 int ring_buffer_freesize(RingBufferContext* ctx)
 {
-	return ctx->buffer_size - ctx->data_size;
+	return ctx->buffer_size - ring_buffer_datasize(ctx);
 }
 
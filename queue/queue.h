@@ -5,26 +5,94 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+#define RING_BUFFER_CACHELINE 64
+
+/*
+ * Read/write positions run over [0, 2 * size) so that a full and an empty
+ * ring can be told apart without a shared counter. Each side owns one
+ * cache line: the consumer writes head, the producer writes tail, and each
+ * keeps a private copy of the other's position that it only refreshes
+ * when the cached value says the ring is empty/full.
+ */
+typedef struct {
+	uint32_t head __attribute__((aligned(RING_BUFFER_CACHELINE)));
+	uint32_t tail_cache;
+	uint32_t tail __attribute__((aligned(RING_BUFFER_CACHELINE)));
+	uint32_t head_cache;
+	/* blocking waits: bytes a sleeping side needs, and the futex words it sleeps on */
+	uint32_t read_want __attribute__((aligned(RING_BUFFER_CACHELINE)));
+	uint32_t write_want;
+	uint32_t read_event;
+	uint32_t write_event;
+	uint32_t closed;
+}RingBufferIndex;
+
+/* ring_buffer_init_mode() allocation modes */
+#define RING_BUFFER_MALLOC 0
+/* map the buffer twice back-to-back so every span is contiguous (Linux memfd) */
+#define RING_BUFFER_MIRROR 1
+
+/* named ring in POSIX shared memory, see ring_buffer_shm_open() */
+#define RING_BUFFER_SHM 2
+
+/* record mode: every record is a native-endian uint32_t length followed by the payload */
+#define RING_BUFFER_RECORD_HEADER ((int)sizeof(uint32_t))
+
+/*
+ * First page of a shared-memory ring. It holds only sizes and positions,
+ * never pointers, so every process may map it at a different address;
+ * the data follows at data_offset.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t size;
+	uint32_t data_offset;
+	RingBufferIndex index;
+}RingBufferShmHeader;
 
 typedef struct {
 	uint8_t* buffer_base;
 	uint8_t* buffer_end;
 	int buffer_size;
-	uint8_t* data_ptr;
-	int data_size;
+	int mode;
+	RingBufferIndex* index;
 }RingBufferContext;
 
-pthread_mutex_t iolock;
+/* only needed when several threads share one side of a ring; process-private */
+extern pthread_mutex_t iolock;
 
 int ring_buffer_write(RingBufferContext* ctx, uint8_t* buffer, int size);
 int ring_buffer_read(RingBufferContext* ctx, uint8_t* buffer, int size);
 int ring_buffer_init(RingBufferContext* ctx, int size);
+int ring_buffer_init_mode(RingBufferContext* ctx, int size, int mode);
 void ring_buffer_free(RingBufferContext* ctx);
+int ring_buffer_shm_open(RingBufferContext* ctx, const char* name, int size, int oflag);
+int ring_buffer_shm_unlink(const char* name);
 int ring_buffer_datasize(RingBufferContext* ctx);
 int ring_buffer_buffersize(RingBufferContext* ctx);
 int ring_buffer_freesize(RingBufferContext* ctx);
 int read_data(RingBufferContext* ctx, uint8_t* buffer, int buf_size);
 int write_data(RingBufferContext* ctx, uint8_t* buffer, int buf_size);
+int ring_buffer_wait_data(RingBufferContext* ctx, int size, int timeout_ms);
+int ring_buffer_wait_space(RingBufferContext* ctx, int size, int timeout_ms);
+int ring_buffer_read_wait(RingBufferContext* ctx, uint8_t* buffer, int size, int timeout_ms);
+int ring_buffer_write_wait(RingBufferContext* ctx, uint8_t* buffer, int size, int timeout_ms);
+void ring_buffer_close(RingBufferContext* ctx);
+int ring_buffer_reserve(RingBufferContext* ctx, struct iovec iov[2]);
+int ring_buffer_commit(RingBufferContext* ctx, int size);
+int ring_buffer_peek(RingBufferContext* ctx, struct iovec iov[2]);
+int ring_buffer_consume(RingBufferContext* ctx, int size);
+int ring_buffer_write_record(RingBufferContext* ctx, const uint8_t* data, int size);
+int ring_buffer_write_record_wait(RingBufferContext* ctx, const uint8_t* data, int size, int timeout_ms);
+int ring_buffer_peek_record(RingBufferContext* ctx, struct iovec iov[2]);
+int ring_buffer_consume_record(RingBufferContext* ctx);
+int ring_buffer_read_record(RingBufferContext* ctx, uint8_t* buffer, int size);
+int ring_buffer_read_record_wait(RingBufferContext* ctx, uint8_t* buffer, int size, int timeout_ms);
+int ring_buffer_read_records(RingBufferContext* ctx, uint8_t* buffer, int size, int* lens, int max_records);
+int ring_buffer_closed(RingBufferContext* ctx);
 
 
 #endif //QUEUE_H_
\ No newline at end of file
@@ -5,69 +5,52 @@
 #include "queue.h"
 
 RingBufferContext ring_buffer;
-pthread_mutex_t iolock;
 //char *file = "/opt/nfsroot/cache/db/test";
 //char *file = "/opt/nfsroot/cache/db/1.doc";
 char *file = "/opt/nfsroot/cache/db/10003196.mkv";
-char buffer1[32768], buffer2[32768];
+#define CHUNK 32768
 int fd = 0, fd2 = 0;
 FILE *fp = NULL;
 FILE *fp_r = NULL;
 pthread_t input_id, output_id;
-int flags = 0;
 
 void* thrd_input()
 {
-	int ret = 0;
 	int size = 0;
+	struct iovec iov[2];
 	
 	fd = open(file, O_RDONLY);
 	//fp_r = fopen(file, "r")
 	if(fd == -1){
 		printf("Cannot open file.\n");
-		flags = 1;
+		ring_buffer_close(&ring_buffer);
 		pthread_exit(NULL);
 		//return (void*)(-1);
 	}
 	while(1){
-		memset(buffer1, 0, sizeof(buffer1));
-		
-		size = read(fd, buffer1, sizeof(buffer1));
-		printf("read ret = %d\n", ret);
+		//read() straight into the ring
+		if(ring_buffer_wait_space(&ring_buffer, CHUNK, -1) < 0)
+		{
+			printf("Consumer closed the ring.\n");
+			break;
+		}
+		ring_buffer_reserve(&ring_buffer, iov);
+		size = readv(fd, iov, 2);
+		printf("read ret = %d\n", size);
 		if(size < 0) {
 			printf("Cannot read from file.\n");
-			flags = 1;
+			ring_buffer_close(&ring_buffer);
 			pthread_exit(NULL);
 			//return (void *)(-1);
 		} else if (size == 0) {
 			printf("read ok.\n");
 			break;
 		} else {
-		rewrite:
-			pthread_mutex_lock(&iolock);
-			/*
-			if(ring_buffer_datasize(&ring_buffer) == ring_buffer_buffersize(&ring_buffer))
-			{
-				pthread_mutex_unlock(&iolock);
-				usleep(1);
-				goto redo;
-			}
-			ring_buffer_write(&ring_buffer,  (uint8_t *)buffer1, ret);
-			*/
-			
-			ret = write_data(&ring_buffer,  (uint8_t *)buffer1, size);
-			if(0 == ret || -1 == ret) 
-			{
-				pthread_mutex_unlock(&iolock);
-				usleep(1);
-				goto rewrite;
-			}
-			
-			pthread_mutex_unlock(&iolock);
+			ring_buffer_commit(&ring_buffer, size);
 		}
 	}
 	
-	flags = 1;
+	ring_buffer_close(&ring_buffer);
 	pthread_exit(NULL);
 	//return (void *)(0);
 }
@@ -75,7 +58,7 @@ void* thrd_input()
 void* thrd_output()
 {
     int ret = 0;
-	int size = 0;
+	struct iovec iov[2];
 	fd2 = open("./1.mkv", O_WRONLY | O_CREAT | O_TRUNC);
 	if(fd < 0){
 		printf("Cannot open file.\n");
@@ -84,52 +67,21 @@ void* thrd_output()
 	}
 	
 	while(1){
-		memset(buffer2, 0, sizeof(buffer2));
-	reread:
-		pthread_mutex_lock(&iolock);
-		/*
-		ret = ring_buffer_datasize(&ring_buffer);
-		if(ret == 0)
+		//write() straight out of the ring
+		if(ring_buffer_wait_data(&ring_buffer, CHUNK, -1) <= 0)
 		{
-			if(flags == 1) {
-				pthread_mutex_unlock(&iolock);
-				printf("write ok.\n");
-				break;
-			} else {		
-				pthread_mutex_unlock(&iolock);
-				continue;
-			}
-		} else if (ret > 0) {
-			ret = ring_buffer_read(&ring_buffer,  (uint8_t *)buffer2, sizeof(buffer2));
-			pthread_mutex_unlock(&iolock);
-			printf("write ret = %d\n", ret);
-			write(fd2, buffer2, ret);
-		} else {
-			//error
-			pthread_mutex_unlock(&iolock);
-		}
-		*/
-		ret = read_data(&ring_buffer,  (uint8_t *)buffer2, sizeof(buffer2));
-		size = ret;
-		if(0 == ret )
-		{
-			pthread_mutex_unlock(&iolock);
-			if(1 == flags) 
-			{
-				break;
-			}
-			else 
-			{
-				usleep(1);
-				goto reread;
-			}
+			printf("write ok.\n");
+			break;
 		}
-		else 
+		ring_buffer_peek(&ring_buffer, iov);
+		ret = writev(fd2, iov, 2);
+		if(ret < 0)
 		{
-			pthread_mutex_unlock(&iolock);
-			write(fd2, buffer2, size);
+			printf("Cannot write to file.\n");
+			ring_buffer_close(&ring_buffer);
+			break;
 		}
-		
+		ring_buffer_consume(&ring_buffer, ret);
 	}
 	pthread_exit(NULL);
 	//return (void *)(0);
@@ -138,8 +90,10 @@ void* thrd_output()
 int main(void)
 {
 	//int ret = 0;
-	ring_buffer_init(&ring_buffer, 1024*1024);
-	pthread_mutex_init(&iolock, NULL);
+	if(ring_buffer_init_mode(&ring_buffer, 1024*1024, RING_BUFFER_MIRROR) != 0) {
+		printf("Init ring buffer error!\n");
+		return -1;
+	}
 	
 	if(pthread_create(&input_id, NULL, thrd_input, NULL) != 0) {
 		printf("Create input_thread error!\n");
@@ -164,7 +118,6 @@ int main(void)
 	}else
 		printf("output_thread Joined!\n");
 	
-	pthread_mutex_destroy(&iolock);
 	ring_buffer_free(&ring_buffer);
 	printf("ok.\n");
 	
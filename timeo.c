@@ -132,3 +132,168 @@ int sftime(char *pstr, int size, const char *format)
 	return iRet;
 }
 
+/** @brief ʱʽֶ */
+enum {
+	SFT_YEAR4,
+	SFT_YEAR2,
+	SFT_MON,
+	SFT_DAY,
+	SFT_HOUR,
+	SFT_MIN,
+	SFT_SEC,
+	SFT_MSEC,
+	SFT_USEC
+};
+
+/**
+ * @brief д붨ʮ֡
+ */
+static void sft_digits(char *p, unsigned long v, int n)
+{
+	while (n-- > 0) {
+		p[n] = '0' + v % 10;
+		v /= 10;
+	}
+}
+
+/**
+ * @brief ʱʽʽֻɨһΣ֮sftimecֶα
+ *
+ * @param fmt 
+ * @param format ʱڸʽsftimeͬ
+ * @param flags 0SFT_COARSE
+ *
+ * @return ַĳȣʽ-1
+ */
+int sftime_compile(SFTIME_FMT *fmt, const char *format, const int flags)
+{
+	const char *p = format;
+	int op, n, len = 0;
+	SFT_TOKEN *tok;
+
+	memset(fmt, 0, sizeof(*fmt));
+	fmt->flags = flags;
+	fmt->sec = (time_t)-1;
+	while (*p != '\0') {
+		if (*p == 'y' && *(p + 1) == 'y') {
+			if (*(p + 2) == 'y' && *(p + 3) == 'y') {
+				op = SFT_YEAR4, n = 4, p += 4;
+			} else {
+				op = SFT_YEAR2, n = 2, p += 2;
+			}
+		} else if (*p == 'm' && *(p + 1) == 'm') {
+			op = SFT_MON, n = 2, p += 2;
+		} else if (*p == 'd' && *(p + 1) == 'd') {
+			op = SFT_DAY, n = 2, p += 2;
+		} else if (*p == 'h' && *(p + 1) == 'h') {
+			op = SFT_HOUR, n = 2, p += 2;
+		} else if (*p == 'm' && *(p + 1) == 'i') {
+			op = SFT_MIN, n = 2, p += 2;
+		} else if (*p == 's' && *(p + 1) == 's') {
+			op = SFT_SEC, n = 2, p += 2;
+		} else if (*p == 'm' && *(p + 1) == 's') {
+			op = SFT_MSEC, n = 3, p += 2;
+		} else if (*p == 'u' && *(p + 1) == 's') {
+			op = SFT_USEC, n = 6, p += 2;
+		} else {
+			if (len + 1 > SFT_MAXLEN) {
+				errno = EINVAL;
+				return -1;
+			}
+			fmt->buf[len++] = *p++;
+			continue;
+		}
+		if (len + n > SFT_MAXLEN) {
+			errno = EINVAL;
+			return -1;
+		}
+		if (op >= SFT_MSEC) {
+			if (fmt->nsub == SFT_TOKENS) {
+				errno = EINVAL;
+				return -1;
+			}
+			tok = &fmt->sub_tok[fmt->nsub++];
+		} else {
+			if (fmt->nsec == SFT_TOKENS) {
+				errno = EINVAL;
+				return -1;
+			}
+			tok = &fmt->sec_tok[fmt->nsec++];
+		}
+		tok->op = op;
+		tok->pos = len;
+		len += n;
+	}
+	fmt->len = len;
+	return len;
+}
+
+/**
+ * @brief ĸʽǰʱַ
+ *
+ * @param pstr ַ壬ռ㹻ʱ'\0'β
+ * @param size ַС
+ * @param fmt sftime_compileʱʽ
+ *
+ * @return ʵַĳȣ岻㷵-1
+ */
+int sftimec(char *pstr, int size, SFTIME_FMT *fmt)
+{
+	int i;
+	long usec;
+	struct tm ts;
+	struct timespec tv;
+	SFT_TOKEN *tok;
+
+	if (fmt->len > size) {
+		errno = EINVAL;
+		return -1;
+	}
+#ifdef CLOCK_REALTIME_COARSE
+	clock_gettime((fmt->flags & SFT_COARSE) ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME, &tv);
+#else
+	clock_gettime(CLOCK_REALTIME, &tv);
+#endif
+	if (tv.tv_sec != fmt->sec) {
+		localtime_r(&tv.tv_sec, &ts);
+		for (i = 0, tok = fmt->sec_tok; i < fmt->nsec; i++, tok++) {
+			switch (tok->op) {
+			case SFT_YEAR4:
+				sft_digits(fmt->buf + tok->pos, ts.tm_year + 1900, 4);
+				break;
+			case SFT_YEAR2:
+				sft_digits(fmt->buf + tok->pos, (ts.tm_year + 1900) % 100, 2);
+				break;
+			case SFT_MON:
+				sft_digits(fmt->buf + tok->pos, ts.tm_mon + 1, 2);
+				break;
+			case SFT_DAY:
+				sft_digits(fmt->buf + tok->pos, ts.tm_mday, 2);
+				break;
+			case SFT_HOUR:
+				sft_digits(fmt->buf + tok->pos, ts.tm_hour, 2);
+				break;
+			case SFT_MIN:
+				sft_digits(fmt->buf + tok->pos, ts.tm_min, 2);
+				break;
+			default:
+				sft_digits(fmt->buf + tok->pos, ts.tm_sec, 2);
+				break;
+			}
+		}
+		fmt->sec = tv.tv_sec;
+	}
+	usec = tv.tv_nsec / 1000;
+	for (i = 0, tok = fmt->sub_tok; i < fmt->nsub; i++, tok++) {
+		if (tok->op == SFT_MSEC) {
+			sft_digits(fmt->buf + tok->pos, usec / 1000, 3);
+		} else {
+			sft_digits(fmt->buf + tok->pos, usec, 6);
+		}
+	}
+	memcpy(pstr, fmt->buf, fmt->len);
+	if (fmt->len < size) {
+		pstr[fmt->len] = '\0';
+	}
+	return fmt->len;
+}
@@ -9,9 +9,41 @@
 #ifndef __TIMEO_H__
 #define __TIMEO_H__
 
+#include <time.h>
 #include "types.h"
 
+/** @brief ʱʽ */
+#define SFT_MAXLEN 64
+/** @brief ʱʽֶ */
+#define SFT_TOKENS 16
+/** @brief CLOCK_REALTIME_COARSEȡʱͣΪϵͳʱӽ(1-10)usֶ */
+#define SFT_COARSE 0x01
+
+/** @brief ʱʽֶ */
+typedef struct {
+	unsigned char op;		/* ֶ */
+	unsigned char pos;		/* еλ */
+}SFT_TOKEN;
+
+/**
+ * @brief ʱʽ
+ * ͬʱһѸʽֻ仯ʱ¼ʱ룬
+ * ڵĵֻдms/usֶΡ治ÿ߳ӦʹøԵSFTIME_FMT
+ */
+typedef struct {
+	int flags;
+	int len;						/*  */
+	int nsec;						/* 뼶ֶθ */
+	int nsub;						/* ֶθ */
+	SFT_TOKEN sec_tok[SFT_TOKENS];
+	SFT_TOKEN sub_tok[SFT_TOKENS];
+	time_t sec;						/* Ӧ룬Ҳһȡʱ */
+	char buf[SFT_MAXLEN + 1];
+}SFTIME_FMT;
+
 int sftime(char *pstr, int size, const char *format);
+int sftime_compile(SFTIME_FMT *fmt, const char *format, const int flags);
+int sftimec(char *pstr, int size, SFTIME_FMT *fmt);
 
 #endif /*__TIMEO_H__*/
 
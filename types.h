@@ -89,6 +89,20 @@ typedef long S32;
 typedef S32 s32;
 #endif
 
+#ifndef U64
+typedef unsigned long long U64;
+#endif
+#ifndef u64
+typedef U64 u64;
+#endif
+
+#ifndef S64
+typedef long long S64;
+#endif
+#ifndef s64
+typedef S64 s64;
+#endif
+
 #ifndef BOOL
 typedef int BOOL;
 #endif